@@ -0,0 +1,674 @@
+// ============================================================================
+// benchmark_tiff_codecs.cxx (ITK_Playground) - Benchmark TIFF codecs
+//
+//  Copyright (C) 2024 Ljubomir Kurij <ljubomir_kurij@protonmail.com>
+//
+// "ITK Playground" is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option)
+// any later version.
+//
+// "ITK Playground" is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with Focus Precision Analyze. If not, see <https://www.gnu.org/licenses/>.
+// ============================================================================
+
+
+// ============================================================================
+//
+// 2024-09-23 Ljubomir Kurij <ljubomir_kurij@protonmail.com>
+//
+// * benchmark_tiff_codecs.cxx: created.
+//
+// ============================================================================
+
+
+// ============================================================================
+// Preprocessor directives section
+// ============================================================================
+
+
+// ============================================================================
+// Headers include section
+// ============================================================================
+
+// Related header
+
+// "C" headers
+#include <cctype>                    // required by std::tolower
+#include <cstdlib>                   // required by EXIT_SUCCESS, EXIT_FAILURE
+#include <cstring>                   // required by std::memcmp
+
+// Standard Library headers
+#include <algorithm>                 // required by std::min, std::sort
+#include <chrono>                    // required by std::chrono
+#include <exception>                 // required by std::current_exception
+#include <filesystem>                // required by std::filesystem
+#include <iomanip>                   // required by std::setw
+#include <iostream>                  // required by cin, cout, ...
+#include <limits>                    // required by std::numeric_limits
+#include <string>                    // required by std::string
+#include <vector>                    // required by std::vector
+
+// External libraries headers
+#include <clipp.hpp>                 // command line arguments parsing
+#include <itkImage.h>                // required by itk::Image
+#include <itkImageFileReader.h>      // required for reading image data
+#include <itkImageFileWriter.h>      // required for writing image data
+#include <itkImageRegionIteratorWithIndex.h>  // required for filling the
+                                              // synthetic scan
+#include <itkRGBPixel.h>             // required by itk::RGBPixel
+#include <itkTIFFImageIO.h>          // required for reading and writing
+                                     // TIFF images
+
+
+// ============================================================================
+// Global constants section
+// ============================================================================
+
+static const std::string kAppName = "benchmark_tiff_codecs";
+static const std::string kVersionString = "0.1";
+static const std::string kYearString = "2024";
+static const std::string kAuthorName = "Ljubomir Kurij";
+static const std::string kAuthorEmail = "ljubomir_kurij@protonmail.com";
+static const std::string kAppDoc = "\
+Compare the compression codecs and predictors of the patched\n\
+itk::TIFFImageIO on 16-bit RGB scans. Every INPUT file, or TIFF file found\n\
+in an INPUT directory, is read as a 16-bit RGB image and written in memory\n\
+with each codec (none, packbits, lzw, deflate, zstd), the last three with\n\
+and without the horizontal predictor. For each combination the compression\n\
+ratio and the write and read speeds in MiB/s of image data are reported,\n\
+and the written file is read back to check that it holds the same pixels.\n\
+The floating point predictor only applies to float images and is not\n\
+benchmarked.\n\n\
+Mandatory arguments to long options are mandatory for short options too.\n";
+static const std::string kLicense = "\
+License GPLv3+: GNU GPL version 3 or later <http://gnu.org/licenses/gpl.html>\n\
+This is free software: you are free to change and redistribute it.\n\
+There is NO WARRANTY, to the extent permitted by law.\n";
+
+
+// ============================================================================
+// Global variables section
+// ============================================================================
+
+static std::string exec_name = kAppName;
+
+
+// ============================================================================
+// Type definitions section
+// ============================================================================
+
+using RGB16Pixel = itk::RGBPixel<uint16_t>;
+using RGB16Image = itk::Image<RGB16Pixel, 2>;
+
+// A compressor and the predictor applied before it
+struct CodecSetting {
+  std::string compression;
+  bool horizontal_predictor;
+};
+
+// Outcome of writing and reading back an image with one codec setting
+struct CodecResult {
+  size_t encoded_bytes;
+  double write_ms;
+  double read_ms;
+  bool match;
+};
+
+
+// ============================================================================
+// Utility function prototypes
+// ============================================================================
+
+void printShortHelp(std::string = kAppName);
+void printUsage(const clipp::group &, const std::string = kAppName,
+                const clipp::doc_formatting & = clipp::doc_formatting{});
+void printVersionInfo();
+void showHelp(const clipp::group &, const std::string = kAppName,
+              const std::string = kAppDoc);
+std::string str_tolower(std::string);
+std::vector<std::filesystem::path> collectTIFFFiles(
+    const std::vector<std::string> &);
+RGB16Image::Pointer makeSyntheticScan(unsigned int);
+RGB16Image::Pointer readScan(const std::string &);
+CodecResult benchmarkCodec(const RGB16Image *, const CodecSetting &, int,
+                           unsigned int, unsigned int);
+
+
+// ============================================================================
+// Main Function Section
+// ============================================================================
+
+int main(int argc, char *argv[]) {
+  namespace fs = std::filesystem; // Filesystem alias
+
+  // Determine the exec name under wich program is beeing executed
+  fs::path exec_path{argv[0]};
+  exec_name = exec_path.filename().string();
+
+  // Here we define the structure for holding the passed command line otions.
+  // The structure is also used to define the command line options and their
+  // default values.
+  struct CLIOptions {
+    bool show_help;
+    bool print_usage;
+    bool show_version;
+    std::vector<std::string> inputs;
+    unsigned int synthetic_size;
+    int zstd_level;
+    unsigned int threads;
+    unsigned int repeat;
+    std::vector<std::string> unsupported;
+  };
+
+  // Define the default values for the command line options
+  CLIOptions user_options{
+      false,        // show_help
+      false,        // print_usage
+      false,        // show_version
+      {},           // inputs
+      0,            // synthetic_size
+      9,            // zstd_level
+      0,            // threads
+      3,            // repeat
+      {}            // unsupported options aggregator
+  };
+
+  // Option filters definitions
+  auto istarget = clipp::match::prefix_not("-"); // Filter out strings that
+                                                 // start with '-' (options)
+
+  // Set command line options
+  auto parser_config = (
+      (
+        clipp::opt_values(istarget, "INPUT", user_options.inputs),
+        clipp::option("-s", "--synthetic")
+          .doc("also benchmark a synthetic 16-bit RGB scan of SIZE x SIZE "
+               "pixels [default: none]")
+        & clipp::value("SIZE", user_options.synthetic_size),
+        clipp::option("-l", "--zstd-level")
+          .doc("level of the zstd compressor, from 1 to 22 [default: 9]")
+        & clipp::value("LEVEL", user_options.zstd_level),
+        clipp::option("-t", "--threads")
+          .doc("number of threads compressing and decoding strips, 0 for "
+               "the ITK default [default: 0]")
+        & clipp::value("N", user_options.threads),
+        clipp::option("-r", "--repeat")
+          .doc("number of timed writes and reads per file and codec, the "
+               "best ones are reported [default: 3]")
+        & clipp::value("N", user_options.repeat),
+        clipp::option("-h", "--help")
+           .set(user_options.show_help)
+           .doc("show this help message and exit"),
+        clipp::option("--usage")
+           .set(user_options.print_usage)
+           .doc("give a short usage message"),
+        clipp::option("-V", "--version")
+           .set(user_options.show_version)
+           .doc("print program version")
+        ).doc("general options:"),
+      clipp::any_other(user_options.unsupported));
+
+  // Execute the main code inside a try block to catch any exceptions and
+  // to ensure that all of the code exits at exactly the same point
+  try {
+    // Parse command line options
+    auto result = clipp::parse(argc, argv, parser_config);
+
+    // Check if the unsupported options were passed
+    if (!user_options.unsupported.empty()) {
+      std::cerr << kAppName << ": Unsupported options: ";
+      for (const auto &opt : user_options.unsupported) {
+        std::cerr << opt << " ";
+      }
+      std::cerr << std::endl;
+      printShortHelp(exec_name);
+
+      throw EXIT_FAILURE;
+    }
+
+    // Check if the help switch was triggered. We give help switch the
+    // highest priority, so if it is triggered we don't need to check
+    // anything else.
+    if (user_options.show_help) {
+      showHelp(parser_config, exec_name);
+
+      throw EXIT_SUCCESS;
+    }
+
+    // Check if the usage switch was triggered. Usge switch has the second
+    // highest priority, so if it is triggered we don't need to check
+    // anything else.
+    if (user_options.print_usage) {
+      auto fmt = clipp::doc_formatting{}.first_column(0).last_column(79);
+      printUsage(parser_config, exec_name, fmt);
+
+      throw EXIT_SUCCESS;
+    }
+
+    // Check if the version switch was triggered. Version switch has the
+    // third highest priority.
+    if (user_options.show_version) {
+      printVersionInfo();
+
+      throw EXIT_SUCCESS;
+    }
+
+    // Check if the zstd level is one the compressor supports
+    if (1 > user_options.zstd_level || 22 < user_options.zstd_level) {
+      std::cerr << kAppName
+        << ": Invalid zstd level value: "
+        << user_options.zstd_level
+        << "\n";
+
+      // Print short help message
+      printShortHelp(exec_name);
+
+      throw EXIT_FAILURE;
+    }
+
+    // No high priority switch was triggered. Now we check if there is
+    // anything to benchmark. If not we print the usage message and exit.
+    if (user_options.inputs.empty() && 0 == user_options.synthetic_size) {
+      auto fmt = clipp::doc_formatting {}
+        .first_column(0)
+        .last_column(79)
+        .merge_alternative_flags_with_common_prefix(true);
+      std::cout << "Usage: ";
+      printUsage(parser_config, exec_name, fmt);
+
+      std::cout << "\n";
+
+      // Print short help message
+      printShortHelp(exec_name);
+
+      throw EXIT_FAILURE;
+    }
+
+    if (0 == user_options.repeat) {
+      user_options.repeat = 1;
+    }
+
+    // Main code goes here ----------------------------------------------------
+    const std::vector<CodecSetting> settings = {
+      {"none", false},
+      {"packbits", false},
+      {"lzw", false},
+      {"lzw", true},
+      {"deflate", false},
+      {"deflate", true},
+      {"zstd", false},
+      {"zstd", true}
+    };
+
+    // Totals of each setting over all of the scans
+    std::vector<double> total_raw(settings.size(), 0.0);
+    std::vector<double> total_encoded(settings.size(), 0.0);
+    std::vector<double> total_write(settings.size(), 0.0);
+    std::vector<double> total_read(settings.size(), 0.0);
+
+    std::vector<std::string> scans;
+    for (const auto &file : collectTIFFFiles(user_options.inputs)) {
+      scans.push_back(file.string());
+    }
+    if (0 < user_options.synthetic_size) {
+      scans.push_back("synthetic");
+    }
+
+    const auto print_header = [](const std::string &first_column) {
+      std::cout << std::left << std::setw(40) << first_column
+        << std::setw(10) << "codec"
+        << std::setw(12) << "predictor"
+        << std::right << std::setw(8) << "ratio"
+        << std::setw(13) << "write MiB/s"
+        << std::setw(12) << "read MiB/s"
+        << std::setw(8) << "match"
+        << "\n";
+    };
+    print_header("file");
+
+    for (const auto &scan : scans) {
+      RGB16Image::Pointer image;
+      try {
+        image = "synthetic" == scan
+          ? makeSyntheticScan(user_options.synthetic_size)
+          : readScan(scan);
+      } catch (const itk::ExceptionObject &error) {
+        std::cout << std::left << std::setw(40) << scan
+          << "skipped: " << error.GetDescription() << "\n";
+        continue;
+      }
+
+      const double raw_bytes = static_cast<double>(
+          image->GetBufferedRegion().GetNumberOfPixels()) * sizeof(RGB16Pixel);
+      const double mib = raw_bytes / (1024.0 * 1024.0);
+      const std::string name = fs::path(scan).filename().string();
+
+      for (size_t index = 0; index < settings.size(); ++index) {
+        const CodecSetting &setting = settings[index];
+        std::cout << std::left << std::setw(40) << name
+          << std::setw(10) << setting.compression
+          << std::setw(12)
+          << (setting.horizontal_predictor ? "horizontal" : "none");
+
+        CodecResult outcome{};
+        try {
+          outcome = benchmarkCodec(
+              image,
+              setting,
+              user_options.zstd_level,
+              user_options.threads,
+              user_options.repeat
+              );
+        } catch (const itk::ExceptionObject &error) {
+          std::cout << "skipped: " << error.GetDescription() << "\n";
+          continue;
+        }
+
+        total_raw[index] += raw_bytes;
+        total_encoded[index] += static_cast<double>(outcome.encoded_bytes);
+        total_write[index] += outcome.write_ms;
+        total_read[index] += outcome.read_ms;
+
+        std::cout << std::right << std::fixed << std::setprecision(2)
+          << std::setw(8) << raw_bytes / outcome.encoded_bytes
+          << std::setw(13) << mib * 1000.0 / outcome.write_ms
+          << std::setw(12) << mib * 1000.0 / outcome.read_ms
+          << std::setw(8) << (outcome.match ? "yes" : "NO")
+          << "\n";
+      }
+    }
+
+    // Print the totals of each setting over all of the scans
+    std::cout << "\n";
+    print_header("total");
+    for (size_t index = 0; index < settings.size(); ++index) {
+      if (0.0 == total_encoded[index]) {
+        continue;
+      }
+
+      const CodecSetting &setting = settings[index];
+      const double mib = total_raw[index] / (1024.0 * 1024.0);
+      std::cout << std::left << std::setw(40) << ""
+        << std::setw(10) << setting.compression
+        << std::setw(12)
+        << (setting.horizontal_predictor ? "horizontal" : "none")
+        << std::right << std::fixed << std::setprecision(2)
+        << std::setw(8) << total_raw[index] / total_encoded[index]
+        << std::setw(13) << mib * 1000.0 / total_write[index]
+        << std::setw(12) << mib * 1000.0 / total_read[index]
+        << "\n";
+    }
+
+    // Return success
+    throw EXIT_SUCCESS;
+
+  } catch (int result) {
+    // Return the result of the main code
+    return result;
+
+  } catch (...) {
+    // We have an unhandled exception. Print error message and exit
+    try {
+      std::rethrow_exception(std::current_exception());
+    } catch (const std::exception &e) {
+      std::cerr << kAppName << ": Unhandled exception: " << e.what()
+                << std::endl;
+    }
+
+    // Return an error code
+    return EXIT_FAILURE;
+  }
+
+  // The code should never reach this point. If it does, print an error
+  // message and exit
+  std::cerr << kAppName << ": Unhandled program exit!" << std::endl;
+
+  return EXIT_FAILURE;
+}
+
+
+// ============================================================================
+// Function definitions
+// ============================================================================
+
+inline void printShortHelp(std::string exec_name) {
+  std::cout << "Try '" << exec_name << " --help' for more information.\n";
+}
+
+inline void printUsage(const clipp::group &group, const std::string prefix,
+                       const clipp::doc_formatting &fmt) {
+  std::cout << clipp::usage_lines(group, prefix, fmt) << "\n";
+}
+
+void printVersionInfo() {
+  std::cout << kAppName << " " << kVersionString << " Copyright (C) "
+            << kYearString << " " << kAuthorName << "\n"
+            << kLicense;
+}
+
+void showHelp(const clipp::group &group, const std::string exec_name,
+              const std::string doc) {
+  auto fmt = clipp::doc_formatting{}.first_column(0).last_column(79);
+  clipp::man_page man;
+
+  man.prepend_section("USAGE", clipp::usage_lines(group, exec_name, fmt).str());
+  man.append_section("", doc);
+  man.append_section("", clipp::documentation(group, fmt).str());
+  man.append_section("", "Report bugs to <" + kAuthorEmail + ">.");
+
+  std::cout << man;
+}
+
+std::string str_tolower(std::string s) {
+  std::transform(
+    s.begin(),
+    s.end(),
+    s.begin(),
+    [](unsigned char c){ return std::tolower(c); }
+    );
+
+  return s;
+}
+
+// ----------------------------------------------------------------------------
+// collectTIFFFiles
+// ----------------------------------------------------------------------------
+//
+// Description:
+// Expand the list of the passed inputs into the sorted list of TIFF files.
+// Directories are searched recursively for files with the '.tif' or '.tiff'
+// extension. Inputs that do not exist are reported and ignored.
+//
+// ----------------------------------------------------------------------------
+std::vector<std::filesystem::path> collectTIFFFiles(
+    const std::vector<std::string> &inputs) {
+  namespace fs = std::filesystem;
+
+  auto is_tiff = [](const fs::path &path) {
+    const std::string ext = str_tolower(path.extension().string());
+    return ".tif" == ext || ".tiff" == ext;
+  };
+
+  std::vector<fs::path> files;
+  for (const auto &input : inputs) {
+    if (fs::is_directory(input)) {
+      std::vector<fs::path> found;
+      for (const auto &entry : fs::recursive_directory_iterator(input)) {
+        if (entry.is_regular_file() && is_tiff(entry.path())) {
+          found.push_back(entry.path());
+        }
+      }
+      std::sort(found.begin(), found.end());
+      files.insert(files.end(), found.begin(), found.end());
+    } else if (fs::is_regular_file(input)) {
+      files.emplace_back(input);
+    } else {
+      std::cerr << kAppName << ": Ignoring missing input: " << input << "\n";
+    }
+  }
+
+  return files;
+}
+
+// ----------------------------------------------------------------------------
+// makeSyntheticScan
+// ----------------------------------------------------------------------------
+//
+// Description:
+// Create a size x size 16-bit RGB image resembling a film scan (smooth
+// gradients with a fine texture).
+//
+// ----------------------------------------------------------------------------
+RGB16Image::Pointer makeSyntheticScan(unsigned int size) {
+  RGB16Image::RegionType region;
+  region.SetSize(0, size);
+  region.SetSize(1, size);
+
+  auto image = RGB16Image::New();
+  image->SetRegions(region);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<RGB16Image> it(image, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it) {
+    const auto index = it.GetIndex();
+    const auto x = static_cast<uint64_t>(index[0]);
+    const auto y = static_cast<uint64_t>(index[1]);
+    RGB16Pixel pixel;
+    pixel.SetRed(static_cast<uint16_t>((x * 65535u) / size + (y & 7u)));
+    pixel.SetGreen(static_cast<uint16_t>((y * 65535u) / size + (x & 7u)));
+    pixel.SetBlue(static_cast<uint16_t>(((x + y) * 32767u) / size));
+    it.Set(pixel);
+  }
+
+  return image;
+}
+
+// ----------------------------------------------------------------------------
+// readScan
+// ----------------------------------------------------------------------------
+//
+// Description:
+// Read the given file as a 16-bit RGB image.
+//
+// Exceptions:
+// Throws itk::ExceptionObject if the file can not be read.
+//
+// ----------------------------------------------------------------------------
+RGB16Image::Pointer readScan(const std::string &file_name) {
+  using RGB16Reader = itk::ImageFileReader<RGB16Image>;
+
+  auto reader = RGB16Reader::New();
+  reader->SetFileName(file_name);
+  reader->SetImageIO(itk::TIFFImageIO::New());
+  reader->Update();
+
+  return reader->GetOutput();
+}
+
+// ----------------------------------------------------------------------------
+// benchmarkCodec
+// ----------------------------------------------------------------------------
+//
+// Description:
+// Write the image in memory through itk::TIFFImageIO with the given codec
+// setting and read it back from memory. Reports the size of the written
+// file, the best write and read wall times of the given number of runs in
+// milliseconds, and whether the file read back holds the pixels of the
+// image.
+//
+// Exceptions:
+// Throws itk::ExceptionObject if the image can not be written with the
+// codec setting, e.g. when libtiff is built without the codec.
+//
+// ----------------------------------------------------------------------------
+CodecResult benchmarkCodec(
+    const RGB16Image *image,
+    const CodecSetting &setting,
+    int zstd_level,
+    unsigned int threads,
+    unsigned int repeat
+    ) {
+  using RGB16Reader = itk::ImageFileReader<RGB16Image>;
+  using RGB16Writer = itk::ImageFileWriter<RGB16Image>;
+
+  // The file name only names the image in the messages of the image IO
+  const std::string file_name = kAppName + ".tif";
+
+  CodecResult outcome{0, std::numeric_limits<double>::max(),
+                      std::numeric_limits<double>::max(), false};
+  std::vector<char> encoded;
+
+  for (unsigned int run = 0; run < repeat; ++run) {
+    auto tiffImageIO = itk::TIFFImageIO::New();
+    tiffImageIO->WriteToMemoryOn();
+    tiffImageIO->SetNumberOfThreads(threads);
+    if ("packbits" == setting.compression) {
+      tiffImageIO->SetCompressionToPackBits();
+    } else if ("lzw" == setting.compression) {
+      tiffImageIO->SetCompressionToLZW();
+    } else if ("deflate" == setting.compression) {
+      tiffImageIO->SetCompressionToDeflate();
+    } else if ("zstd" == setting.compression) {
+      tiffImageIO->SetCompressionToZSTD();
+      tiffImageIO->SetZSTDLevel(zstd_level);
+    } else {
+      tiffImageIO->SetCompressionToNoCompression();
+    }
+    tiffImageIO->SetPredictor(
+        setting.horizontal_predictor
+          ? itk::TIFFImageIO::HorizontalPredictor
+          : itk::TIFFImageIO::NoPredictor
+        );
+
+    auto writer = RGB16Writer::New();
+    writer->SetFileName(file_name);
+    writer->SetInput(image);
+    writer->SetImageIO(tiffImageIO);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    writer->Update();
+
+    const auto stop = std::chrono::steady_clock::now();
+    const std::chrono::duration<double, std::milli> elapsed = stop - start;
+    outcome.write_ms = std::min(outcome.write_ms, elapsed.count());
+
+    encoded = tiffImageIO->GetMemoryOutput();
+  }
+  outcome.encoded_bytes = encoded.size();
+
+  const size_t pixels = image->GetBufferedRegion().GetNumberOfPixels();
+  for (unsigned int run = 0; run < repeat; ++run) {
+    auto tiffImageIO = itk::TIFFImageIO::New();
+    tiffImageIO->SetMemorySource(encoded.data(), encoded.size());
+    tiffImageIO->SetNumberOfThreads(threads);
+
+    auto reader = RGB16Reader::New();
+    reader->SetFileName(file_name);
+    reader->SetImageIO(tiffImageIO);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    reader->Update();
+
+    const auto stop = std::chrono::steady_clock::now();
+    const std::chrono::duration<double, std::milli> elapsed = stop - start;
+    outcome.read_ms = std::min(outcome.read_ms, elapsed.count());
+
+    const RGB16Image *decoded = reader->GetOutput();
+    outcome.match = decoded->GetBufferedRegion() == image->GetBufferedRegion()
+      && 0 == std::memcmp(
+          decoded->GetBufferPointer(),
+          image->GetBufferPointer(),
+          pixels * sizeof(RGB16Pixel)
+          );
+  }
+
+  return outcome;
+}
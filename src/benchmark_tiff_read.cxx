@@ -0,0 +1,629 @@
+// ============================================================================
+// benchmark_tiff_read.cxx (ITK_Playground) - Benchmark TIFF read paths
+//
+//  Copyright (C) 2024 Ljubomir Kurij <ljubomir_kurij@protonmail.com>
+//
+// "ITK Playground" is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option)
+// any later version.
+//
+// "ITK Playground" is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with Focus Precision Analyze. If not, see <https://www.gnu.org/licenses/>.
+// ============================================================================
+
+
+// ============================================================================
+//
+// 2024-09-02 Ljubomir Kurij <ljubomir_kurij@protonmail.com>
+//
+// * benchmark_tiff_read.cxx: created.
+//
+// ============================================================================
+
+
+// ============================================================================
+// Preprocessor directives section
+// ============================================================================
+
+
+// ============================================================================
+// Headers include section
+// ============================================================================
+
+// Related header
+
+// "C" headers
+#include <cctype>                    // required by std::tolower
+#include <cstdlib>                   // required by EXIT_SUCCESS, EXIT_FAILURE
+#include <cstring>                   // required by std::memcmp
+
+// Standard Library headers
+#include <algorithm>                 // required by std::min, std::sort
+#include <chrono>                    // required by std::chrono
+#include <exception>                 // required by std::current_exception
+#include <filesystem>                // required by std::filesystem
+#include <iomanip>                   // required by std::setw
+#include <iostream>                  // required by cin, cout, ...
+#include <limits>                    // required by std::numeric_limits
+#include <string>                    // required by std::string
+#include <vector>                    // required by std::vector
+
+// External libraries headers
+#include <clipp.hpp>                 // command line arguments parsing
+#include <itkImage.h>                // required by itk::Image
+#include <itkImageFileWriter.h>      // required for writing image data to file
+#include <itkImageRegionIteratorWithIndex.h>  // required for filling the
+                                              // synthetic scan
+#include <itkTIFFImageIO.h>          // required for reading and writing
+                                     // TIFF images
+
+
+// ============================================================================
+// Global constants section
+// ============================================================================
+
+static const std::string kAppName = "benchmark_tiff_read";
+static const std::string kVersionString = "0.1";
+static const std::string kYearString = "2024";
+static const std::string kAuthorName = "Ljubomir Kurij";
+static const std::string kAuthorEmail = "ljubomir_kurij@protonmail.com";
+static const std::string kAppDoc = "\
+Compare the scanline and the strip based TIFF read paths of the patched\n\
+itk::TIFFImageIO. INPUT can be a TIFF file or a directory that is searched\n\
+recursively for TIFF files (e.g. the libtiff pics-3.8.0 corpus). With\n\
+--read-ahead the strip path fetches strips on a background thread; drop the\n\
+page cache before each run to measure cold storage.\n\n\
+Mandatory arguments to long options are mandatory for short options too.\n";
+static const std::string kLicense = "\
+License GPLv3+: GNU GPL version 3 or later <http://gnu.org/licenses/gpl.html>\n\
+This is free software: you are free to change and redistribute it.\n\
+There is NO WARRANTY, to the extent permitted by law.\n";
+
+
+// ============================================================================
+// Global variables section
+// ============================================================================
+
+static std::string exec_name = kAppName;
+
+
+// ============================================================================
+// Utility function prototypes
+// ============================================================================
+
+void printShortHelp(std::string = kAppName);
+void printUsage(const clipp::group &, const std::string = kAppName,
+                const clipp::doc_formatting & = clipp::doc_formatting{});
+void printVersionInfo();
+void showHelp(const clipp::group &, const std::string = kAppName,
+              const std::string = kAppDoc);
+std::string str_tolower(std::string);
+std::vector<std::filesystem::path> collectTIFFFiles(
+    const std::vector<std::string> &);
+void writeSyntheticScan(const std::string &, unsigned int, bool);
+void writeSyntheticPaletteStack(const std::string &, unsigned int);
+double timeRead(const std::string &, bool, bool, unsigned int,
+                std::vector<char> &);
+
+
+// ============================================================================
+// Main Function Section
+// ============================================================================
+
+int main(int argc, char *argv[]) {
+  namespace fs = std::filesystem; // Filesystem alias
+
+  // Determine the exec name under wich program is beeing executed
+  fs::path exec_path{argv[0]};
+  exec_name = exec_path.filename().string();
+
+  // Here we define the structure for holding the passed command line otions.
+  // The structure is also used to define the command line options and their
+  // default values.
+  struct CLIOptions {
+    bool show_help;
+    bool print_usage;
+    bool show_version;
+    std::vector<std::string> inputs;
+    unsigned int synthetic_size;
+    unsigned int repeat;
+    bool read_ahead;
+    std::vector<std::string> unsupported;
+  };
+
+  // Define the default values for the command line options
+  CLIOptions user_options{
+      false,        // show_help
+      false,        // print_usage
+      false,        // show_version
+      {},           // inputs
+      0,            // synthetic_size
+      3,            // repeat
+      false,        // read_ahead
+      {}            // unsupported options aggregator
+  };
+
+  // Option filters definitions
+  auto istarget = clipp::match::prefix_not("-"); // Filter out strings that
+                                                 // start with '-' (options)
+
+  // Set command line options
+  auto parser_config = (
+      (
+        clipp::opt_values(istarget, "INPUT", user_options.inputs),
+        clipp::option("-s", "--synthetic")
+          .doc("also benchmark synthetic 16-bit RGB scans of SIZE x SIZE "
+               "pixels [default: none]")
+        & clipp::value("SIZE", user_options.synthetic_size),
+        clipp::option("-r", "--repeat")
+          .doc("number of timed reads per file and path, the best one is "
+               "reported [default: 3]")
+        & clipp::value("N", user_options.repeat),
+        clipp::option("-a", "--read-ahead")
+          .set(user_options.read_ahead)
+          .doc("read the strips ahead of decoding in the strip path"),
+        clipp::option("-h", "--help")
+           .set(user_options.show_help)
+           .doc("show this help message and exit"),
+        clipp::option("--usage")
+           .set(user_options.print_usage)
+           .doc("give a short usage message"),
+        clipp::option("-V", "--version")
+           .set(user_options.show_version)
+           .doc("print program version")
+        ).doc("general options:"),
+      clipp::any_other(user_options.unsupported));
+
+  // Execute the main code inside a try block to catch any exceptions and
+  // to ensure that all of the code exits at exactly the same point
+  try {
+    // Parse command line options
+    auto result = clipp::parse(argc, argv, parser_config);
+
+    // Check if the unsupported options were passed
+    if (!user_options.unsupported.empty()) {
+      std::cerr << kAppName << ": Unsupported options: ";
+      for (const auto &opt : user_options.unsupported) {
+        std::cerr << opt << " ";
+      }
+      std::cerr << std::endl;
+      printShortHelp(exec_name);
+
+      throw EXIT_FAILURE;
+    }
+
+    // Check if the help switch was triggered. We give help switch the
+    // highest priority, so if it is triggered we don't need to check
+    // anything else.
+    if (user_options.show_help) {
+      showHelp(parser_config, exec_name);
+
+      throw EXIT_SUCCESS;
+    }
+
+    // Check if the usage switch was triggered. Usge switch has the second
+    // highest priority, so if it is triggered we don't need to check
+    // anything else.
+    if (user_options.print_usage) {
+      auto fmt = clipp::doc_formatting{}.first_column(0).last_column(79);
+      printUsage(parser_config, exec_name, fmt);
+
+      throw EXIT_SUCCESS;
+    }
+
+    // Check if the version switch was triggered. Version switch has the
+    // third highest priority.
+    if (user_options.show_version) {
+      printVersionInfo();
+
+      throw EXIT_SUCCESS;
+    }
+
+    // No high priority switch was triggered. Now we check if there is
+    // anything to benchmark. If not we print the usage message and exit.
+    if (user_options.inputs.empty() && 0 == user_options.synthetic_size) {
+      auto fmt = clipp::doc_formatting {}
+        .first_column(0)
+        .last_column(79)
+        .merge_alternative_flags_with_common_prefix(true);
+      std::cout << "Usage: ";
+      printUsage(parser_config, exec_name, fmt);
+
+      std::cout << "\n";
+
+      // Print short help message
+      printShortHelp(exec_name);
+
+      throw EXIT_FAILURE;
+    }
+
+    if (0 == user_options.repeat) {
+      user_options.repeat = 1;
+    }
+
+    // Main code goes here ----------------------------------------------------
+    std::vector<fs::path> files = collectTIFFFiles(user_options.inputs);
+
+    // Generate the synthetic scans in the temporary directory. We write
+    // both an uncompressed and a Deflate compressed variant, and a stack of
+    // palette pages.
+    std::vector<fs::path> synthetic_files;
+    if (0 < user_options.synthetic_size) {
+      const std::string size_tag = std::to_string(user_options.synthetic_size);
+      for (bool compressed : {false, true}) {
+        fs::path synthetic = fs::temp_directory_path()
+          / (kAppName + "_" + size_tag + (compressed ? "_deflate" : "_raw")
+              + ".tif");
+        std::cout << kAppName << ": Writing synthetic scan: "
+          << synthetic.string() << "\n";
+        writeSyntheticScan(
+            synthetic.string(),
+            user_options.synthetic_size,
+            compressed
+            );
+        synthetic_files.push_back(synthetic);
+        files.push_back(synthetic);
+      }
+
+      fs::path synthetic = fs::temp_directory_path()
+        / (kAppName + "_" + size_tag + "_palette.tif");
+      std::cout << kAppName << ": Writing synthetic palette stack: "
+        << synthetic.string() << "\n";
+      writeSyntheticPaletteStack(
+          synthetic.string(),
+          user_options.synthetic_size
+          );
+      synthetic_files.push_back(synthetic);
+      files.push_back(synthetic);
+    }
+
+    std::cout << std::left << std::setw(40) << "file"
+      << std::right << std::setw(10) << "MiB"
+      << std::setw(14) << "scanline ms"
+      << std::setw(12) << "strip ms"
+      << std::setw(10) << "speedup"
+      << std::setw(8) << "match"
+      << "\n";
+
+    std::vector<char> scanline_buffer;
+    std::vector<char> strip_buffer;
+    double total_scanline = 0.0;
+    double total_strip = 0.0;
+    for (const auto &file : files) {
+      const std::string file_name = file.string();
+      std::string label = file.filename().string();
+      if (label.size() > 38) {
+        label = label.substr(0, 35) + "...";
+      }
+
+      double scanline_ms = 0.0;
+      double strip_ms = 0.0;
+      try {
+        scanline_ms = timeRead(
+            file_name,
+            true,
+            false,
+            user_options.repeat,
+            scanline_buffer
+            );
+        strip_ms = timeRead(
+            file_name,
+            false,
+            user_options.read_ahead,
+            user_options.repeat,
+            strip_buffer
+            );
+      } catch (const itk::ExceptionObject &error) {
+        std::cout << std::left << std::setw(40) << label
+          << "skipped: " << error.GetDescription() << "\n";
+        continue;
+      }
+
+      const bool match = scanline_buffer.size() == strip_buffer.size()
+        && 0 == std::memcmp(
+            scanline_buffer.data(),
+            strip_buffer.data(),
+            strip_buffer.size()
+            );
+
+      total_scanline += scanline_ms;
+      total_strip += strip_ms;
+
+      std::cout << std::left << std::setw(40) << label
+        << std::right << std::fixed << std::setprecision(2)
+        << std::setw(10)
+        << static_cast<double>(strip_buffer.size()) / (1024.0 * 1024.0)
+        << std::setw(14) << scanline_ms
+        << std::setw(12) << strip_ms
+        << std::setw(9) << (0.0 < strip_ms ? scanline_ms / strip_ms : 0.0)
+        << "x"
+        << std::setw(8) << (match ? "yes" : "NO")
+        << "\n";
+    }
+
+    std::cout << std::left << std::setw(50) << "total"
+      << std::right << std::fixed << std::setprecision(2)
+      << std::setw(14) << total_scanline
+      << std::setw(12) << total_strip
+      << std::setw(9)
+      << (0.0 < total_strip ? total_scanline / total_strip : 0.0)
+      << "x\n";
+
+    // Clean up the synthetic scans
+    for (const auto &synthetic : synthetic_files) {
+      std::error_code ec;
+      fs::remove(synthetic, ec);
+    }
+
+    // Return success
+    throw EXIT_SUCCESS;
+
+  } catch (int result) {
+    // Return the result of the main code
+    return result;
+
+  } catch (...) {
+    // We have an unhandled exception. Print error message and exit
+    try {
+      std::rethrow_exception(std::current_exception());
+    } catch (const std::exception &e) {
+      std::cerr << kAppName << ": Unhandled exception: " << e.what()
+                << std::endl;
+    }
+
+    // Return an error code
+    return EXIT_FAILURE;
+  }
+
+  // The code should never reach this point. If it does, print an error
+  // message and exit
+  std::cerr << kAppName << ": Unhandled program exit!" << std::endl;
+
+  return EXIT_FAILURE;
+}
+
+
+// ============================================================================
+// Function definitions
+// ============================================================================
+
+inline void printShortHelp(std::string exec_name) {
+  std::cout << "Try '" << exec_name << " --help' for more information.\n";
+}
+
+inline void printUsage(const clipp::group &group, const std::string prefix,
+                       const clipp::doc_formatting &fmt) {
+  std::cout << clipp::usage_lines(group, prefix, fmt) << "\n";
+}
+
+void printVersionInfo() {
+  std::cout << kAppName << " " << kVersionString << " Copyright (C) "
+            << kYearString << " " << kAuthorName << "\n"
+            << kLicense;
+}
+
+void showHelp(const clipp::group &group, const std::string exec_name,
+              const std::string doc) {
+  auto fmt = clipp::doc_formatting{}.first_column(0).last_column(79);
+  clipp::man_page man;
+
+  man.prepend_section("USAGE", clipp::usage_lines(group, exec_name, fmt).str());
+  man.append_section("", doc);
+  man.append_section("", clipp::documentation(group, fmt).str());
+  man.append_section("", "Report bugs to <" + kAuthorEmail + ">.");
+
+  std::cout << man;
+}
+
+std::string str_tolower(std::string s) {
+  std::transform(
+    s.begin(),
+    s.end(),
+    s.begin(),
+    [](unsigned char c){ return std::tolower(c); }
+    );
+
+  return s;
+}
+
+// ----------------------------------------------------------------------------
+// collectTIFFFiles
+// ----------------------------------------------------------------------------
+//
+// Description:
+// Expand the list of the passed inputs into the sorted list of TIFF files.
+// Directories are searched recursively for files with the '.tif' or '.tiff'
+// extension. Inputs that do not exist are reported and ignored.
+//
+// ----------------------------------------------------------------------------
+std::vector<std::filesystem::path> collectTIFFFiles(
+    const std::vector<std::string> &inputs) {
+  namespace fs = std::filesystem;
+
+  auto is_tiff = [](const fs::path &path) {
+    const std::string ext = str_tolower(path.extension().string());
+    return ".tif" == ext || ".tiff" == ext;
+  };
+
+  std::vector<fs::path> files;
+  for (const auto &input : inputs) {
+    if (fs::is_directory(input)) {
+      std::vector<fs::path> found;
+      for (const auto &entry : fs::recursive_directory_iterator(input)) {
+        if (entry.is_regular_file() && is_tiff(entry.path())) {
+          found.push_back(entry.path());
+        }
+      }
+      std::sort(found.begin(), found.end());
+      files.insert(files.end(), found.begin(), found.end());
+    } else if (fs::is_regular_file(input)) {
+      files.emplace_back(input);
+    } else {
+      std::cerr << kAppName << ": Ignoring missing input: " << input << "\n";
+    }
+  }
+
+  return files;
+}
+
+// ----------------------------------------------------------------------------
+// writeSyntheticScan
+// ----------------------------------------------------------------------------
+//
+// Description:
+// Write a size x size 16-bit RGB image resembling a film scan (smooth
+// gradients with a fine texture) to the given file, optionally Deflate
+// compressed.
+//
+// ----------------------------------------------------------------------------
+void writeSyntheticScan(
+    const std::string &file_name,
+    unsigned int size,
+    bool compressed
+    ) {
+  using RGB16Pixel = itk::RGBPixel<uint16_t>;
+  using RGB16Image = itk::Image<RGB16Pixel, 2>;
+  using RGB16Writer = itk::ImageFileWriter<RGB16Image>;
+
+  RGB16Image::RegionType region;
+  region.SetSize(0, size);
+  region.SetSize(1, size);
+
+  auto image = RGB16Image::New();
+  image->SetRegions(region);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<RGB16Image> it(image, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it) {
+    const auto index = it.GetIndex();
+    const auto x = static_cast<uint64_t>(index[0]);
+    const auto y = static_cast<uint64_t>(index[1]);
+    RGB16Pixel pixel;
+    pixel.SetRed(static_cast<uint16_t>((x * 65535u) / size + (y & 7u)));
+    pixel.SetGreen(static_cast<uint16_t>((y * 65535u) / size + (x & 7u)));
+    pixel.SetBlue(static_cast<uint16_t>(((x + y) * 32767u) / size));
+    it.Set(pixel);
+  }
+
+  auto tiffImageIO = itk::TIFFImageIO::New();
+  if (compressed) {
+    tiffImageIO->SetCompressionToDeflate();
+  } else {
+    tiffImageIO->SetCompressionToNoCompression();
+  }
+
+  auto writer = RGB16Writer::New();
+  writer->SetFileName(file_name);
+  writer->SetInput(image);
+  writer->SetImageIO(tiffImageIO);
+  writer->Update();
+}
+
+// ----------------------------------------------------------------------------
+// writeSyntheticPaletteStack
+// ----------------------------------------------------------------------------
+//
+// Description:
+// Write four size x size pages of 8-bit palette indices to the given file,
+// every page carrying the same color map, so the multi-page palette read
+// path is timed and compared as well.
+//
+// ----------------------------------------------------------------------------
+void writeSyntheticPaletteStack(
+    const std::string &file_name,
+    unsigned int size
+    ) {
+  using PaletteImage = itk::Image<unsigned char, 3>;
+  using PaletteWriter = itk::ImageFileWriter<PaletteImage>;
+
+  PaletteImage::RegionType region;
+  region.SetSize(0, size);
+  region.SetSize(1, size);
+  region.SetSize(2, 4);
+
+  auto image = PaletteImage::New();
+  image->SetRegions(region);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<PaletteImage> it(image, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it) {
+    const auto index = it.GetIndex();
+    it.Set(static_cast<unsigned char>(index[0] + index[1] + 64 * index[2]));
+  }
+
+  itk::TIFFImageIO::PaletteType palette(256);
+  for (unsigned int i = 0; i < palette.size(); ++i) {
+    palette[i].SetRed(static_cast<uint16_t>(257 * i));
+    palette[i].SetGreen(static_cast<uint16_t>(257 * (255 - i)));
+    palette[i].SetBlue(static_cast<uint16_t>(257 * ((7 * i) & 255)));
+  }
+
+  auto tiffImageIO = itk::TIFFImageIO::New();
+  tiffImageIO->SetCompressionToNoCompression();
+  tiffImageIO->SetWritePalette(true);
+  tiffImageIO->SetColorPalette(palette);
+
+  auto writer = PaletteWriter::New();
+  writer->SetFileName(file_name);
+  writer->SetInput(image);
+  writer->SetImageIO(tiffImageIO);
+  writer->Update();
+}
+
+// ----------------------------------------------------------------------------
+// timeRead
+// ----------------------------------------------------------------------------
+//
+// Description:
+// Read the whole image (all pages) through itk::TIFFImageIO into the buffer
+// using either the scanline or the strip read path, the latter optionally
+// with strip read-ahead. Returns the best wall time of the given number of
+// runs in milliseconds.
+//
+// Exceptions:
+// Throws itk::ExceptionObject if the file can not be read.
+//
+// ----------------------------------------------------------------------------
+double timeRead(
+    const std::string &file_name,
+    bool use_scanline,
+    bool use_read_ahead,
+    unsigned int repeat,
+    std::vector<char> &buffer
+    ) {
+  double best = std::numeric_limits<double>::max();
+
+  for (unsigned int run = 0; run < repeat; ++run) {
+    auto tiffImageIO = itk::TIFFImageIO::New();
+    tiffImageIO->SetUseScanlineReading(use_scanline);
+    tiffImageIO->SetUseReadAhead(use_read_ahead);
+    tiffImageIO->SetFileName(file_name);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    tiffImageIO->ReadImageInformation();
+
+    const unsigned int dimension = tiffImageIO->GetNumberOfDimensions();
+    itk::ImageIORegion region(dimension);
+    for (unsigned int d = 0; d < dimension; ++d) {
+      region.SetIndex(d, 0);
+      region.SetSize(d, tiffImageIO->GetDimensions(d));
+    }
+    tiffImageIO->SetIORegion(region);
+
+    buffer.resize(tiffImageIO->GetImageSizeInBytes());
+    tiffImageIO->Read(buffer.data());
+
+    const auto stop = std::chrono::steady_clock::now();
+    const std::chrono::duration<double, std::milli> elapsed = stop - start;
+    best = std::min(best, elapsed.count());
+  }
+
+  return best;
+}
@@ -0,0 +1,553 @@
+// ============================================================================
+// benchmark_tiff_write.cxx (ITK_Playground) - Benchmark TIFF write paths
+//
+//  Copyright (C) 2024 Ljubomir Kurij <ljubomir_kurij@protonmail.com>
+//
+// "ITK Playground" is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option)
+// any later version.
+//
+// "ITK Playground" is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with Focus Precision Analyze. If not, see <https://www.gnu.org/licenses/>.
+// ============================================================================
+
+
+// ============================================================================
+//
+// 2024-09-16 Ljubomir Kurij <ljubomir_kurij@protonmail.com>
+//
+// * benchmark_tiff_write.cxx: created.
+//
+// ============================================================================
+
+
+// ============================================================================
+// Preprocessor directives section
+// ============================================================================
+
+
+// ============================================================================
+// Headers include section
+// ============================================================================
+
+// Related header
+
+// "C" headers
+#include <cctype>                    // required by std::tolower
+#include <cstdlib>                   // required by EXIT_SUCCESS, EXIT_FAILURE
+#include <cstring>                   // required by std::memcmp
+
+// Standard Library headers
+#include <algorithm>                 // required by std::min
+#include <chrono>                    // required by std::chrono
+#include <exception>                 // required by std::current_exception
+#include <filesystem>                // required by std::filesystem
+#include <iomanip>                   // required by std::setw
+#include <iostream>                  // required by cin, cout, ...
+#include <limits>                    // required by std::numeric_limits
+#include <string>                    // required by std::string
+#include <vector>                    // required by std::vector
+
+// External libraries headers
+#include <clipp.hpp>                 // command line arguments parsing
+#include <itkImage.h>                // required by itk::Image
+#include <itkImageFileReader.h>      // required for reading image data
+#include <itkImageFileWriter.h>      // required for writing image data to file
+#include <itkImageRegionIteratorWithIndex.h>  // required for filling the
+                                              // synthetic scan
+#include <itkRGBPixel.h>             // required by itk::RGBPixel
+#include <itkTIFFImageIO.h>          // required for reading and writing
+                                     // TIFF images
+
+
+// ============================================================================
+// Global constants section
+// ============================================================================
+
+static const std::string kAppName = "benchmark_tiff_write";
+static const std::string kVersionString = "0.1";
+static const std::string kYearString = "2024";
+static const std::string kAuthorName = "Ljubomir Kurij";
+static const std::string kAuthorEmail = "ljubomir_kurij@protonmail.com";
+static const std::string kAppDoc = "\
+Compare the scanline and the strip based TIFF write paths of the patched\n\
+itk::TIFFImageIO on synthetic 16-bit RGB scans of SIZE x SIZE pixels. The\n\
+scans are written to the temporary directory and read back to check that\n\
+both paths store the same pixels.\n\n\
+Mandatory arguments to long options are mandatory for short options too.\n";
+static const std::string kLicense = "\
+License GPLv3+: GNU GPL version 3 or later <http://gnu.org/licenses/gpl.html>\n\
+This is free software: you are free to change and redistribute it.\n\
+There is NO WARRANTY, to the extent permitted by law.\n";
+
+
+// ============================================================================
+// Global variables section
+// ============================================================================
+
+static std::string exec_name = kAppName;
+
+
+// ============================================================================
+// Type definitions section
+// ============================================================================
+
+using RGB16Pixel = itk::RGBPixel<uint16_t>;
+using RGB16Image = itk::Image<RGB16Pixel, 2>;
+
+
+// ============================================================================
+// Utility function prototypes
+// ============================================================================
+
+void printShortHelp(std::string = kAppName);
+void printUsage(const clipp::group &, const std::string = kAppName,
+                const clipp::doc_formatting & = clipp::doc_formatting{});
+void printVersionInfo();
+void showHelp(const clipp::group &, const std::string = kAppName,
+              const std::string = kAppDoc);
+std::string str_tolower(std::string);
+RGB16Image::Pointer makeSyntheticScan(unsigned int);
+double timeWrite(const RGB16Image *, const std::string &, const std::string &,
+                 bool, unsigned int, unsigned int);
+bool matchesImage(const RGB16Image *, const std::string &);
+
+
+// ============================================================================
+// Main Function Section
+// ============================================================================
+
+int main(int argc, char *argv[]) {
+  namespace fs = std::filesystem; // Filesystem alias
+
+  // Determine the exec name under wich program is beeing executed
+  fs::path exec_path{argv[0]};
+  exec_name = exec_path.filename().string();
+
+  // Here we define the structure for holding the passed command line otions.
+  // The structure is also used to define the command line options and their
+  // default values.
+  struct CLIOptions {
+    bool show_help;
+    bool print_usage;
+    bool show_version;
+    std::vector<std::string> sizes;
+    std::string compression;
+    unsigned int threads;
+    unsigned int repeat;
+    std::vector<std::string> unsupported;
+  };
+
+  // Define the default values for the command line options
+  CLIOptions user_options{
+      false,        // show_help
+      false,        // print_usage
+      false,        // show_version
+      {},           // sizes
+      "none",       // compression
+      0,            // threads
+      3,            // repeat
+      {}            // unsupported options aggregator
+  };
+
+  // Option filters definitions
+  auto istarget = clipp::match::prefix_not("-"); // Filter out strings that
+                                                 // start with '-' (options)
+
+  // Set command line options
+  auto parser_config = (
+      (
+        clipp::opt_values(istarget, "SIZE", user_options.sizes),
+        clipp::option("-c", "--compression")
+          .doc("compression of the written scans (none, packbits, lzw, "
+               "deflate) [default: none]")
+        & clipp::value(istarget, "COMPRESSION", user_options.compression),
+        clipp::option("-t", "--threads")
+          .doc("number of threads compressing strips, 0 for the ITK "
+               "default [default: 0]")
+        & clipp::value("N", user_options.threads),
+        clipp::option("-r", "--repeat")
+          .doc("number of timed writes per size and path, the best one is "
+               "reported [default: 3]")
+        & clipp::value("N", user_options.repeat),
+        clipp::option("-h", "--help")
+           .set(user_options.show_help)
+           .doc("show this help message and exit"),
+        clipp::option("--usage")
+           .set(user_options.print_usage)
+           .doc("give a short usage message"),
+        clipp::option("-V", "--version")
+           .set(user_options.show_version)
+           .doc("print program version")
+        ).doc("general options:"),
+      clipp::any_other(user_options.unsupported));
+
+  // Execute the main code inside a try block to catch any exceptions and
+  // to ensure that all of the code exits at exactly the same point
+  try {
+    // Parse command line options
+    auto result = clipp::parse(argc, argv, parser_config);
+
+    // Check if the unsupported options were passed
+    if (!user_options.unsupported.empty()) {
+      std::cerr << kAppName << ": Unsupported options: ";
+      for (const auto &opt : user_options.unsupported) {
+        std::cerr << opt << " ";
+      }
+      std::cerr << std::endl;
+      printShortHelp(exec_name);
+
+      throw EXIT_FAILURE;
+    }
+
+    // Check if the help switch was triggered. We give help switch the
+    // highest priority, so if it is triggered we don't need to check
+    // anything else.
+    if (user_options.show_help) {
+      showHelp(parser_config, exec_name);
+
+      throw EXIT_SUCCESS;
+    }
+
+    // Check if the usage switch was triggered. Usge switch has the second
+    // highest priority, so if it is triggered we don't need to check
+    // anything else.
+    if (user_options.print_usage) {
+      auto fmt = clipp::doc_formatting{}.first_column(0).last_column(79);
+      printUsage(parser_config, exec_name, fmt);
+
+      throw EXIT_SUCCESS;
+    }
+
+    // Check if the version switch was triggered. Version switch has the
+    // third highest priority.
+    if (user_options.show_version) {
+      printVersionInfo();
+
+      throw EXIT_SUCCESS;
+    }
+
+    // Check if the compression is one the writer supports for 16-bit
+    // images
+    const std::string compression = str_tolower(user_options.compression);
+    if (
+        "none" != compression
+        && "packbits" != compression
+        && "lzw" != compression
+        && "deflate" != compression
+        ) {
+      std::cerr << kAppName
+        << ": Invalid compression value: "
+        << user_options.compression
+        << "\n";
+
+      // Print short help message
+      printShortHelp(exec_name);
+
+      throw EXIT_FAILURE;
+    }
+
+    // Parse the sizes of the synthetic scans. Without any we benchmark the
+    // 2k, 8k and 16k scans.
+    std::vector<unsigned int> sizes;
+    for (const auto &size : user_options.sizes) {
+      unsigned long value = 0;
+      try {
+        value = std::stoul(size);
+      } catch (const std::exception &) {
+        value = 0;
+      }
+      if (0 == value || std::numeric_limits<uint32_t>::max() < value) {
+        std::cerr << kAppName << ": Invalid size value: " << size << "\n";
+
+        // Print short help message
+        printShortHelp(exec_name);
+
+        throw EXIT_FAILURE;
+      }
+      sizes.push_back(static_cast<unsigned int>(value));
+    }
+    if (sizes.empty()) {
+      sizes = {2048, 8192, 16384};
+    }
+
+    if (0 == user_options.repeat) {
+      user_options.repeat = 1;
+    }
+
+    // Main code goes here ----------------------------------------------------
+    std::cout << std::left << std::setw(12) << "size"
+      << std::right << std::setw(10) << "MiB"
+      << std::setw(14) << "scanline ms"
+      << std::setw(12) << "strip ms"
+      << std::setw(10) << "speedup"
+      << std::setw(8) << "match"
+      << "\n";
+
+    double total_scanline = 0.0;
+    double total_strip = 0.0;
+    for (unsigned int size : sizes) {
+      const std::string size_tag = std::to_string(size);
+      const fs::path scanline_file = fs::temp_directory_path()
+        / (kAppName + "_" + size_tag + "_scanline.tif");
+      const fs::path strip_file = fs::temp_directory_path()
+        / (kAppName + "_" + size_tag + "_strip.tif");
+
+      const RGB16Image::Pointer image = makeSyntheticScan(size);
+
+      double scanline_ms = 0.0;
+      double strip_ms = 0.0;
+      bool match = false;
+      try {
+        scanline_ms = timeWrite(
+            image,
+            scanline_file.string(),
+            compression,
+            true,
+            user_options.threads,
+            user_options.repeat
+            );
+        strip_ms = timeWrite(
+            image,
+            strip_file.string(),
+            compression,
+            false,
+            user_options.threads,
+            user_options.repeat
+            );
+        match = matchesImage(image, scanline_file.string())
+          && matchesImage(image, strip_file.string());
+      } catch (const itk::ExceptionObject &error) {
+        std::cout << std::left << std::setw(12) << size_tag
+          << "skipped: " << error.GetDescription() << "\n";
+      }
+
+      // Clean up the written scans
+      std::error_code ec;
+      fs::remove(scanline_file, ec);
+      fs::remove(strip_file, ec);
+
+      if (0.0 == strip_ms) {
+        continue;
+      }
+
+      total_scanline += scanline_ms;
+      total_strip += strip_ms;
+
+      const double mib = static_cast<double>(size) * size
+        * sizeof(RGB16Pixel) / (1024.0 * 1024.0);
+      std::cout << std::left << std::setw(12) << size_tag
+        << std::right << std::fixed << std::setprecision(2)
+        << std::setw(10) << mib
+        << std::setw(14) << scanline_ms
+        << std::setw(12) << strip_ms
+        << std::setw(9) << (0.0 < strip_ms ? scanline_ms / strip_ms : 0.0)
+        << "x"
+        << std::setw(8) << (match ? "yes" : "NO")
+        << "\n";
+    }
+
+    std::cout << std::left << std::setw(22) << "total"
+      << std::right << std::fixed << std::setprecision(2)
+      << std::setw(14) << total_scanline
+      << std::setw(12) << total_strip
+      << std::setw(9)
+      << (0.0 < total_strip ? total_scanline / total_strip : 0.0)
+      << "x\n";
+
+    // Return success
+    throw EXIT_SUCCESS;
+
+  } catch (int result) {
+    // Return the result of the main code
+    return result;
+
+  } catch (...) {
+    // We have an unhandled exception. Print error message and exit
+    try {
+      std::rethrow_exception(std::current_exception());
+    } catch (const std::exception &e) {
+      std::cerr << kAppName << ": Unhandled exception: " << e.what()
+                << std::endl;
+    }
+
+    // Return an error code
+    return EXIT_FAILURE;
+  }
+
+  // The code should never reach this point. If it does, print an error
+  // message and exit
+  std::cerr << kAppName << ": Unhandled program exit!" << std::endl;
+
+  return EXIT_FAILURE;
+}
+
+
+// ============================================================================
+// Function definitions
+// ============================================================================
+
+inline void printShortHelp(std::string exec_name) {
+  std::cout << "Try '" << exec_name << " --help' for more information.\n";
+}
+
+inline void printUsage(const clipp::group &group, const std::string prefix,
+                       const clipp::doc_formatting &fmt) {
+  std::cout << clipp::usage_lines(group, prefix, fmt) << "\n";
+}
+
+void printVersionInfo() {
+  std::cout << kAppName << " " << kVersionString << " Copyright (C) "
+            << kYearString << " " << kAuthorName << "\n"
+            << kLicense;
+}
+
+void showHelp(const clipp::group &group, const std::string exec_name,
+              const std::string doc) {
+  auto fmt = clipp::doc_formatting{}.first_column(0).last_column(79);
+  clipp::man_page man;
+
+  man.prepend_section("USAGE", clipp::usage_lines(group, exec_name, fmt).str());
+  man.append_section("", doc);
+  man.append_section("", clipp::documentation(group, fmt).str());
+  man.append_section("", "Report bugs to <" + kAuthorEmail + ">.");
+
+  std::cout << man;
+}
+
+std::string str_tolower(std::string s) {
+  std::transform(
+    s.begin(),
+    s.end(),
+    s.begin(),
+    [](unsigned char c){ return std::tolower(c); }
+    );
+
+  return s;
+}
+
+// ----------------------------------------------------------------------------
+// makeSyntheticScan
+// ----------------------------------------------------------------------------
+//
+// Description:
+// Create a size x size 16-bit RGB image resembling a film scan (smooth
+// gradients with a fine texture).
+//
+// ----------------------------------------------------------------------------
+RGB16Image::Pointer makeSyntheticScan(unsigned int size) {
+  RGB16Image::RegionType region;
+  region.SetSize(0, size);
+  region.SetSize(1, size);
+
+  auto image = RGB16Image::New();
+  image->SetRegions(region);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<RGB16Image> it(image, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it) {
+    const auto index = it.GetIndex();
+    const auto x = static_cast<uint64_t>(index[0]);
+    const auto y = static_cast<uint64_t>(index[1]);
+    RGB16Pixel pixel;
+    pixel.SetRed(static_cast<uint16_t>((x * 65535u) / size + (y & 7u)));
+    pixel.SetGreen(static_cast<uint16_t>((y * 65535u) / size + (x & 7u)));
+    pixel.SetBlue(static_cast<uint16_t>(((x + y) * 32767u) / size));
+    it.Set(pixel);
+  }
+
+  return image;
+}
+
+// ----------------------------------------------------------------------------
+// timeWrite
+// ----------------------------------------------------------------------------
+//
+// Description:
+// Write the image to the given file through itk::TIFFImageIO with the given
+// compression and number of threads, using either the scanline or the strip
+// write path. Returns the best wall time of the given number of runs in
+// milliseconds.
+//
+// Exceptions:
+// Throws itk::ExceptionObject if the file can not be written.
+//
+// ----------------------------------------------------------------------------
+double timeWrite(
+    const RGB16Image *image,
+    const std::string &file_name,
+    const std::string &compression,
+    bool use_scanline,
+    unsigned int threads,
+    unsigned int repeat
+    ) {
+  using RGB16Writer = itk::ImageFileWriter<RGB16Image>;
+
+  double best = std::numeric_limits<double>::max();
+
+  for (unsigned int run = 0; run < repeat; ++run) {
+    auto tiffImageIO = itk::TIFFImageIO::New();
+    tiffImageIO->SetUseScanlineWriting(use_scanline);
+    tiffImageIO->SetNumberOfThreads(threads);
+    if ("packbits" == compression) {
+      tiffImageIO->SetCompressionToPackBits();
+    } else if ("lzw" == compression) {
+      tiffImageIO->SetCompressionToLZW();
+    } else if ("deflate" == compression) {
+      tiffImageIO->SetCompressionToDeflate();
+    } else {
+      tiffImageIO->SetCompressionToNoCompression();
+    }
+
+    auto writer = RGB16Writer::New();
+    writer->SetFileName(file_name);
+    writer->SetInput(image);
+    writer->SetImageIO(tiffImageIO);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    writer->Update();
+
+    const auto stop = std::chrono::steady_clock::now();
+    const std::chrono::duration<double, std::milli> elapsed = stop - start;
+    best = std::min(best, elapsed.count());
+  }
+
+  return best;
+}
+
+// ----------------------------------------------------------------------------
+// matchesImage
+// ----------------------------------------------------------------------------
+//
+// Description:
+// Read the given file back and check that it holds the pixels of the image.
+//
+// Exceptions:
+// Throws itk::ExceptionObject if the file can not be read.
+//
+// ----------------------------------------------------------------------------
+bool matchesImage(const RGB16Image *image, const std::string &file_name) {
+  using RGB16Reader = itk::ImageFileReader<RGB16Image>;
+
+  auto reader = RGB16Reader::New();
+  reader->SetFileName(file_name);
+  reader->SetImageIO(itk::TIFFImageIO::New());
+  reader->Update();
+
+  const RGB16Image *written = reader->GetOutput();
+  const size_t pixels = image->GetBufferedRegion().GetNumberOfPixels();
+
+  return written->GetBufferedRegion() == image->GetBufferedRegion()
+    && 0 == std::memcmp(
+        written->GetBufferPointer(),
+        image->GetBufferPointer(),
+        pixels * sizeof(RGB16Pixel)
+        );
+}
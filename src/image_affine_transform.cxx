@@ -121,6 +121,7 @@ int main(int argc, char *argv[]) {
     bool show_version;
     std::string input_file;
     std::string output_file;
+    unsigned int stream_divisions;
     std::vector<std::string> unsupported;
   };
 
@@ -131,6 +132,7 @@ int main(int argc, char *argv[]) {
       false,        // show_version
       "",           // input_file
       "result.tif", // output_file
+      1,            // stream_divisions
       {}            // unsupported options aggregator
   };
 
@@ -153,6 +155,10 @@ int main(int argc, char *argv[]) {
       (
         clipp::opt_value(istarget, "INPUT_FILE", user_options.input_file),
         clipp::opt_value(istarget, "OUTPUT_FILE", user_options.output_file),
+        clipp::option("-s", "--stream-divisions")
+           .doc("write the output in N row bands, so only a band of it is "
+                "held in memory [default: 1]")
+        & clipp::value("N", user_options.stream_divisions),
         clipp::option("-h", "--help")
            .set(user_options.show_help)
            .doc("show this help message and exit"),
@@ -382,6 +388,7 @@ int main(int argc, char *argv[]) {
       writer->SetFileName(user_options.output_file);
       writer->SetInput(resample->GetOutput());
       writer->SetImageIO(tiffIO);
+      writer->SetNumberOfStreamDivisions(user_options.stream_divisions);
       writer->Update();
       /*
       itk::WriteImage<RGB16Image>(
@@ -39,9 +39,11 @@
 // Related header
 
 // "C" headers
+#include <cctype>                    // required by std::tolower
 #include <cstdlib>                   // required by EXIT_SUCCESS, EXIT_FAILURE
 
 // Standard Library headers
+#include <algorithm>                 // required by std::transform
 #include <exception>                 // required by std::current_exception
 #include <filesystem>                // required by std::filesystem
 #include <iostream>                  // required by cin, cout, ...
@@ -54,6 +56,7 @@
 #include <itkImage.h>                // required by itk::Image
 #include <itkImageFileReader.h>      // required for the reading image data
 #include <itkImageFileWriter.h>      // required for writing image data to file
+#include <itkImportImageFilter.h>    // required for importing mapped pixels
 #include <itkRGBToLuminanceImageFilter.h>  // required for converting RGB to
                                            // luminance image
 #include <itkSmartPointer.h>         // required by itk::SmartPointer
@@ -71,7 +74,9 @@ static constexpr auto kYearString = "2024";
 static constexpr auto kAuthorName = "Ljubomir Kurij";
 static constexpr auto kAuthorEmail = "ljubomir_kurij@protonmail.com";
 static constexpr auto kAppDoc = "\
-Convert RGB image to luminance image.\n\n\
+Convert RGB image to luminance image. If INPUT_FILE is '-' the image is read\n\
+from the standard input and the luminance image is written to the standard\n\
+output.\n\n\
 Mandatory arguments to long options are mandatory for short options too.\n";
 static constexpr auto kLicense = "\
 License GPLv3+: GNU GPL version 3 or later <http://gnu.org/licenses/gpl.html>\n\
@@ -109,6 +114,7 @@ void showHelp(
   const std::string_view & = kAppDoc,
   const std::string_view & = kAuthorEmail
   );
+std::string str_tolower(std::string);
 
 
 // ============================================================================
@@ -145,6 +151,72 @@ public:
 };
 
 
+// ============================================================================
+// User defined template functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// 'getInputImage' template function
+// ----------------------------------------------------------------------------
+//
+// Description:
+// This function returns the input image of the pipeline: the read-only pixels
+// mapped from the file through the importer when the TIFF image IO object
+// can map them, or the output of the reader decoding the file otherwise.
+//
+// Parameters:
+//   tiff_io: TIFF image IO object with the image information already read.
+//   file_name: Name of the input file.
+//   reader: Reader used when the pixel data can not be mapped.
+//   importer: Importer used when the pixel data is mapped.
+//
+// ----------------------------------------------------------------------------
+template <typename ReaderType, typename ImporterType>
+typename ImporterType::OutputImageType * getInputImage(
+    itk::TIFFImageIO *tiff_io,
+    const std::string &file_name,
+    const itk::SmartPointer<ReaderType> &reader,
+    const itk::SmartPointer<ImporterType> &importer
+    ) {
+  using ImageType = typename ImporterType::OutputImageType;
+  using PixelType = typename ImageType::PixelType;
+
+  const void *mapped_pixels = tiff_io->MapPixelData();
+
+  if (nullptr == mapped_pixels) {
+    // Pixel data can not be mapped, decode the file through the already
+    // open TIFF image IO object
+    reader->SetImageIO(tiff_io);
+    reader->SetFileName(file_name);
+
+    return reader->GetOutput();
+  }
+
+  typename ImageType::IndexType start;
+  typename ImageType::SizeType size;
+  typename ImageType::SpacingType spacing;
+  typename ImageType::PointType origin;
+  for (unsigned int i = 0; i < ImageType::ImageDimension; ++i) {
+    start[i] = 0;
+    size[i] = tiff_io->GetDimensions(i);
+    spacing[i] = tiff_io->GetSpacing(i);
+    origin[i] = tiff_io->GetOrigin(i);
+  }
+  typename ImageType::RegionType region(start, size);
+
+  importer->SetRegion(region);
+  importer->SetSpacing(spacing);
+  importer->SetOrigin(origin);
+  importer->SetImportPointer(
+      static_cast<PixelType *>(const_cast<void *>(mapped_pixels)),
+      region.GetNumberOfPixels(),
+      false  // The mapping is released by the TIFF image IO object
+      );
+
+  return importer->GetOutput();
+}
+
+
 // ============================================================================
 // Main Function Section
 // ============================================================================
@@ -165,6 +237,9 @@ int main(int argc, char *argv[]) {
     bool show_version;
     std::string input_file;
     bool overwrite;
+    unsigned int tile_size;
+    unsigned int stream_divisions;
+    unsigned int overviews;
     std::vector<std::string> unsupported;
   };
 
@@ -175,12 +250,18 @@ int main(int argc, char *argv[]) {
       false,        // show_version
       "",           // input_file
       false,        // overwrite
+      0,            // tile_size
+      1,            // stream_divisions
+      0,            // overviews
       {}            // unsupported options aggregator
   };
 
   // Option filters definitions
-  auto istarget = clipp::match::prefix_not("-"); // Filter out strings that
-                                                 // start with '-' (options)
+  // Filter out strings that start with '-' (options), except for the lone
+  // '-' standing for the standard input
+  auto istarget = [](const std::string &arg) {
+    return "-" == arg || clipp::match::prefix_not("-")(arg);
+  };
 
   // Set command line options
   auto parser_config = (
@@ -199,6 +280,18 @@ int main(int argc, char *argv[]) {
         clipp::option("-o", "--overwrite")
           .set(user_options.overwrite)
           .doc("overwrite existing files"),
+        clipp::option("-t", "--tile-size")
+          .doc("write tiled TIFF files of SIZE x SIZE pixels tiles, SIZE "
+               "being a multiple of 16 [default: strips]")
+        & clipp::value("SIZE", user_options.tile_size),
+        clipp::option("-s", "--stream-divisions")
+          .doc("write the output in N row bands, so only a band of it is "
+               "held in memory [default: 1]")
+        & clipp::value("N", user_options.stream_divisions),
+        clipp::option("--overviews")
+          .doc("store N overviews of halved resolution with the output "
+               "[default: 0]")
+        & clipp::value("N", user_options.overviews),
         clipp::option("-h", "--help")
           .set(user_options.show_help)
           .doc("show this help message and exit"),
@@ -256,6 +349,19 @@ int main(int argc, char *argv[]) {
       throw EXIT_SUCCESS;
     }
 
+    // Check if the tile size is one TIFF allows
+    if (0 != user_options.tile_size % 16) {
+      std::cerr << kAppName
+        << ": Tile size is not a multiple of 16: "
+        << user_options.tile_size
+        << "\n";
+
+      // Print short help message
+      printShortHelp(exec_name);
+
+      throw EXIT_FAILURE;
+    }
+
     // No high priority switch was triggered. Now we check if the input
     // file was passed. If not we print the usage message and exit.
     if (user_options.input_file.empty()) {
@@ -274,10 +380,14 @@ int main(int argc, char *argv[]) {
       throw EXIT_FAILURE;
     }
 
-    // Input file was passed. Now we check if the file exists, is
-    // readable and is a regular file and not an empty file.
+    // Input file was passed. With '-' the image is piped through the
+    // standard input and output, so there are no files to check.
+    const bool use_std_streams = "-" == user_options.input_file;
+
+    // Now we check if the file exists, is readable and is a regular file
+    // and not an empty file.
     // Check if the file exists
-    if (!fs::exists (user_options.input_file)) {
+    if (!use_std_streams && !fs::exists (user_options.input_file)) {
       std::cerr << kAppName
         << ": File does not exist: "
         << user_options.input_file
@@ -286,7 +396,7 @@ int main(int argc, char *argv[]) {
     }
 
     // Check if the file is a regular file
-    if (!fs::is_regular_file (user_options.input_file)) {
+    if (!use_std_streams && !fs::is_regular_file (user_options.input_file)) {
       std::cerr << kAppName
         << ": Not a regular file: "
         << user_options.input_file
@@ -295,7 +405,7 @@ int main(int argc, char *argv[]) {
     }
 
     // Check if the file is empty
-    if (fs::file_size (user_options.input_file) == 0) {
+    if (!use_std_streams && fs::file_size (user_options.input_file) == 0) {
       std::cerr << kAppName
         << ": Empty file: "
         << user_options.input_file
@@ -303,36 +413,45 @@ int main(int argc, char *argv[]) {
       throw EXIT_FAILURE;
     }
 
-    // Open the file in binary mode for wider compatibility
-    std::ifstream file (
-      user_options.input_file,
-      std::ios::binary
-      );
-
-    // Check if the file was opened successfully
-    // (if we can read it)
-    if (!file.is_open()) {
-      std::cerr << kAppName
-        << ": Error opening file: "
-        << user_options.input_file
-        << "\n";
-      throw EXIT_FAILURE;
-    }
-
     // Decompose the input file name into the base name and the extension
     std::string out_base_name
       = fs::path(user_options.input_file).stem().string();
     std::string out_extension
       = fs::path(user_options.input_file).extension().string();
 
+    // Output files written to the standard output, for which no image IO is
+    // registered, tiled or with overviews are written with a TIFF image IO
+    // set explicitly
+    const bool use_output_io = use_std_streams
+      || 0 < user_options.tile_size
+      || 0 < user_options.overviews;
+
+    // Files written with the TIFF image IO get a TIFF extension, whatever
+    // the format of the input file is
+    const std::string in_extension = str_tolower(out_extension);
+    if (use_output_io && ".tif" != in_extension && ".tiff" != in_extension) {
+      out_extension = ".tif";
+    }
+
+    const std::string out_file_name = use_std_streams
+      ? "-"
+      : out_base_name + "_luminance" + out_extension;
+    const auto make_output_io = [&]() {
+      auto output_io = itk::TIFFImageIO::New();
+      output_io->SetTileSize(user_options.tile_size, user_options.tile_size);
+      output_io->SetNumberOfOverviews(user_options.overviews);
+      return output_io;
+    };
+
     // Check if the output file(s) already exists
     if (
-        !user_options.overwrite
-        && fs::exists (out_base_name + "_luminance" + out_extension)
+        !use_std_streams
+        && !user_options.overwrite
+        && fs::exists (out_file_name)
         ) {
       std::cerr << kAppName
         << ": Output file already exists: "
-        << out_base_name << "_luminance" << out_extension
+        << out_file_name
         << "\n";
       throw EXIT_FAILURE;
     }
@@ -350,21 +469,12 @@ int main(int argc, char *argv[]) {
       throw EXIT_FAILURE;
     }
 
-    // Set the file name and read the image information
+    // Set the file name and read the baseline tags of the first directory
     tiffImageIO->SetFileName(user_options.input_file);
-    tiffImageIO->ReadImageInformation();
-
-    // Check if we are dealing with an compressed image
-    if (tiffImageIO->ReadCompressionFromImage() != 1) {  // 1 = no compression
-      std::cerr << kAppName
-        << ": File is compressed: "
-        << user_options.input_file
-        << "\n";
-      throw EXIT_FAILURE;
-    }
+    const auto tags = tiffImageIO->ReadTagSnapshot();
 
     // Check if we are dealing with the RGB image
-    if (tiffImageIO->ReadSamplesPerPixelFromImage() != 3) {
+    if (tags.SamplesPerPixel != 3) {
       std::cerr << kAppName
         << ": File is not an RGB image: "
         << user_options.input_file
@@ -373,7 +483,7 @@ int main(int argc, char *argv[]) {
     }
 
     // Check if we are dealing with 16-bit image
-    if (tiffImageIO->ReadBitsPerSampleFromImage() != 16) {
+    if (tags.BitsPerSample != 16) {
       std::cerr << kAppName
         << ": File is not a 16-bit image: "
         << user_options.input_file
@@ -381,6 +491,9 @@ int main(int argc, char *argv[]) {
       throw EXIT_FAILURE;
     }
 
+    // Read the image information only once the header checks out
+    tiffImageIO->ReadImageInformation();
+
     // Define accessor and utility classes for accessing the color channels
     // Define image types for the input and output images
     using RGB16Image = itk::Image<RGB16Pixel, 2>;
@@ -388,6 +501,7 @@ int main(int argc, char *argv[]) {
 
     // Define the image reader and writer types
     using RGB16Reader = itk::ImageFileReader<RGB16Image>;
+    using RGB16Importer = itk::ImportImageFilter<RGB16Pixel, 2>;
     using Mono16Writer = itk::ImageFileWriter<Mono16Image>;
 
     // Define the luminance filter type
@@ -396,12 +510,21 @@ int main(int argc, char *argv[]) {
 
     // Instantiate objects and connect them
     auto reader = RGB16Reader::New();
-    reader->SetFileName(user_options.input_file);
+    auto importer = RGB16Importer::New();
     auto filter = LuminanceFilterType::New();
-    filter->SetInput(reader->GetOutput());
+    filter->SetInput(getInputImage(
+        tiffImageIO,
+        user_options.input_file,
+        reader,
+        importer
+        ));
     auto writer = Mono16Writer::New();
-    writer->SetFileName((out_base_name + "_luminance" + out_extension).c_str());
+    writer->SetFileName(out_file_name.c_str());
     writer->SetInput(filter->GetOutput());
+    if (use_output_io) {
+      writer->SetImageIO(make_output_io());
+    }
+    writer->SetNumberOfStreamDivisions(user_options.stream_divisions);
 
     // Write luminance image to file
     try {
@@ -409,7 +532,7 @@ int main(int argc, char *argv[]) {
     } catch (const itk::ExceptionObject & error) {
       std::cerr << kAppName
         << ": Error writing file: '"
-        << out_base_name << "_luminance" << out_extension
+        << out_file_name
         << "'. "
         << error
         << "\n";
@@ -492,3 +615,14 @@ void showHelp(
 
   std::cout << man;
 }
+
+std::string str_tolower(std::string s) {
+  std::transform(
+    s.begin(),
+    s.end(),
+    s.begin(),
+    [](unsigned char c){ return std::tolower(c); }
+    );
+
+  return s;
+}
@@ -43,6 +43,8 @@
 #include <cstdlib>                   // required by EXIT_SUCCESS, EXIT_FAILURE
 
 // Standard Library headers
+#include <algorithm>                 // required by std::min, std::max
+#include <array>                     // required by std::array
 #include <exception>                 // required by std::current_exception
 #include <filesystem>                // required by std::filesystem
 #include <iostream>                  // required by cin, cout, ...
@@ -53,9 +55,13 @@
 // External libraries headers
 #include <clipp.hpp>                 // command line arguments parsing
 #include <itkImage.h>                // required by itk::Image
-#include <itkImageAdaptor.h>         // required by itk::ImageAdaptor
 #include <itkImageFileReader.h>      // required for the reading image data
 #include <itkImageFileWriter.h>      // required for writing image data to file
+#include <itkImageIORegion.h>        // required by itk::ImageIORegion
+#include <itkImportImageFilter.h>    // required for importing mapped pixels
+#include <itkMultiThreaderBase.h>    // required for splitting the channels in
+                                     // parallel
+#include <itkNumericTraits.h>        // required by itk::NumericTraits
 #include <itkRescaleIntensityImageFilter.h>  // required for rescaling image
                                              // intensities
 #include <itkSmartPointer.h>         // required by itk::SmartPointer
@@ -73,7 +79,9 @@ static const std::string kYearString = "2024";
 static const std::string kAuthorName = "Ljubomir Kurij";
 static const std::string kAuthorEmail = "ljubomir_kurij@protonmail.com";
 static const std::string kAppDoc = "\
-Split color channels of an image.\n\n\
+Split color channels of an image. If INPUT_FILE is '-' the image is read from\n\
+the standard input and the single selected channel is written to the standard\n\
+output.\n\n\
 Mandatory arguments to long options are mandatory for short options too.\n";
 static const std::string kLicense = "\
 License GPLv3+: GNU GPL version 3 or later <http://gnu.org/licenses/gpl.html>\n\
@@ -105,34 +113,391 @@ std::string str_tolower(std::string);
 // Utility class definitions
 // ============================================================================
 
-// Define the color channels
-enum ColorChannel { R, G, B };
-
 // Define the pixel type for the RGB image with 16-bit unsigned integer values
 using RGB16Pixel = itk::RGBPixel<uint16_t>;  // RGB pixel with 16-bit
                                              // unsigned integer values
 
-// Define the accessor class for accessing the color channels of the RGB16Pixel
-template <ColorChannel channel>
-class RGB16ColorChannelAccessor {
-public:
-  using InternalType = RGB16Pixel;
-  using ExternalType = uint16_t;
-
-  static ExternalType
-  Get(const InternalType &input) {
-    switch (channel) {
-      case ColorChannel::R:
-        return input.GetRed();
-      case ColorChannel::G:
-        return input.GetGreen();
-      case ColorChannel::B:
-        return input.GetBlue();
-      default:
-        return 0;  // Should never reach this point
+
+// ============================================================================
+// User defined template functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// 'getInputImage' template function
+// ----------------------------------------------------------------------------
+//
+// Description:
+// This function returns the input image of the pipeline: the read-only pixels
+// mapped from the file through the importer when the TIFF image IO object
+// can map them, or the output of the reader decoding the file otherwise.
+//
+// Parameters:
+//   tiff_io: TIFF image IO object with the image information already read.
+//   file_name: Name of the input file.
+//   reader: Reader used when the pixel data can not be mapped.
+//   importer: Importer used when the pixel data is mapped.
+//
+// ----------------------------------------------------------------------------
+template <typename ReaderType, typename ImporterType>
+typename ImporterType::OutputImageType * getInputImage(
+    itk::TIFFImageIO *tiff_io,
+    const std::string &file_name,
+    const itk::SmartPointer<ReaderType> &reader,
+    const itk::SmartPointer<ImporterType> &importer
+    ) {
+  using ImageType = typename ImporterType::OutputImageType;
+  using PixelType = typename ImageType::PixelType;
+
+  const void *mapped_pixels = tiff_io->MapPixelData();
+
+  if (nullptr == mapped_pixels) {
+    // Pixel data can not be mapped, decode the file through the already
+    // open TIFF image IO object
+    reader->SetImageIO(tiff_io);
+    reader->SetFileName(file_name);
+
+    return reader->GetOutput();
+  }
+
+  typename ImageType::IndexType start;
+  typename ImageType::SizeType size;
+  typename ImageType::SpacingType spacing;
+  typename ImageType::PointType origin;
+  for (unsigned int i = 0; i < ImageType::ImageDimension; ++i) {
+    start[i] = 0;
+    size[i] = tiff_io->GetDimensions(i);
+    spacing[i] = tiff_io->GetSpacing(i);
+    origin[i] = tiff_io->GetOrigin(i);
+  }
+  typename ImageType::RegionType region(start, size);
+
+  importer->SetRegion(region);
+  importer->SetSpacing(spacing);
+  importer->SetOrigin(origin);
+  importer->SetImportPointer(
+      static_cast<PixelType *>(const_cast<void *>(mapped_pixels)),
+      region.GetNumberOfPixels(),
+      false  // The mapping is released by the TIFF image IO object
+      );
+
+  return importer->GetOutput();
+}
+
+
+// ----------------------------------------------------------------------------
+// 'readChannelPlane' template function
+// ----------------------------------------------------------------------------
+//
+// Description:
+// This function reads a single channel of the input file into a new scalar
+// image. For files storing every channel in a separate plane the channel is
+// read with one sequential pass, without touching the other channels or
+// de-interleaving the pixels.
+//
+// Template parameters:
+//   ImageType: The type of the scalar channel image.
+//
+// Parameters:
+//   tiff_io: TIFF image IO object with the image information already read.
+//   sample: Index of the channel (sample) to read.
+//
+// Returns:
+// This function returns the image holding the channel.
+//
+// ----------------------------------------------------------------------------
+template <typename ImageType>
+typename ImageType::Pointer readChannelPlane(
+    itk::TIFFImageIO *tiff_io,
+    unsigned int sample
+    ) {
+  typename ImageType::IndexType start;
+  typename ImageType::SizeType size;
+  typename ImageType::SpacingType spacing;
+  typename ImageType::PointType origin;
+  itk::ImageIORegion io_region(ImageType::ImageDimension);
+  for (unsigned int i = 0; i < ImageType::ImageDimension; ++i) {
+    start[i] = 0;
+    size[i] = tiff_io->GetDimensions(i);
+    spacing[i] = tiff_io->GetSpacing(i);
+    origin[i] = tiff_io->GetOrigin(i);
+    io_region.SetIndex(i, 0);
+    io_region.SetSize(i, size[i]);
+  }
+
+  auto image = ImageType::New();
+  image->SetRegions(typename ImageType::RegionType(start, size));
+  image->SetSpacing(spacing);
+  image->SetOrigin(origin);
+  image->Allocate();
+
+  tiff_io->SetIORegion(io_region);
+  tiff_io->ReadSamplePlane(sample, image->GetBufferPointer());
+
+  return image;
+}
+
+
+// ----------------------------------------------------------------------------
+// 'splitChannels' template function
+// ----------------------------------------------------------------------------
+//
+// Description:
+// This function splits the selected channels of an RGB image into scalar
+// images, stretching each of them to the full range of the channel type
+// exactly like itk::RescaleIntensityImageFilter does. Instead of a minimum
+// and maximum pass and a mapping pass per channel, the ranges of all three
+// channels are gathered in a single parallel pass over the interleaved
+// pixels, and the selected channels are de-interleaved and rescaled in one
+// more. The pixels are processed in blocks small enough to stay in the
+// cache while each selected channel is taken out of them, so the inner
+// loops are plain strided loops the compiler can vectorize.
+//
+// Template parameters:
+//   RGBImageType: The type of the RGB image.
+//   ImageType: The type of the scalar channel images.
+//
+// Parameters:
+//   input: RGB image with its pixels buffered.
+//   selected: Whether the red, green and blue channels are wanted.
+//
+// Returns:
+// This function returns the images of the red, green and blue channels,
+// null for the channels not selected.
+//
+// ----------------------------------------------------------------------------
+template <typename RGBImageType, typename ImageType>
+std::array<typename ImageType::Pointer, 3> splitChannels(
+    const RGBImageType *input,
+    const std::array<bool, 3> &selected
+    ) {
+  using ComponentType = typename ImageType::PixelType;
+  using RealType = typename itk::NumericTraits<ComponentType>::RealType;
+
+  // Number of pixels de-interleaved at a time
+  constexpr itk::SizeValueType kBlockSize = 4096;
+
+  const auto region = input->GetBufferedRegion();
+  const itk::SizeValueType number_of_pixels = region.GetNumberOfPixels();
+  const auto *pixels
+    = reinterpret_cast<const ComponentType *>(input->GetBufferPointer());
+
+  std::array<typename ImageType::Pointer, 3> channels;
+  std::array<ComponentType *, 3> outputs{nullptr, nullptr, nullptr};
+  for (unsigned int c = 0; c < 3; ++c) {
+    if (selected[c]) {
+      channels[c] = ImageType::New();
+      channels[c]->CopyInformation(input);
+      channels[c]->SetRegions(region);
+      channels[c]->Allocate();
+      outputs[c] = channels[c]->GetBufferPointer();
     }
   }
-};
+
+  // Every work unit takes a range of whole blocks
+  auto threader = itk::MultiThreaderBase::New();
+  const itk::SizeValueType number_of_blocks
+    = (number_of_pixels + kBlockSize - 1) / kBlockSize;
+  const itk::SizeValueType number_of_chunks = std::max<itk::SizeValueType>(
+      1,
+      std::min<itk::SizeValueType>(
+        number_of_blocks,
+        threader->GetNumberOfWorkUnits()
+        )
+      );
+  const auto chunk_pixels = [&](itk::SizeValueType chunk) {
+    return std::min(
+        number_of_pixels,
+        chunk * number_of_blocks / number_of_chunks * kBlockSize
+        );
+  };
+
+  // Pass 1: the minimum and maximum of every channel
+  std::vector<std::array<ComponentType, 3>> minima(number_of_chunks);
+  std::vector<std::array<ComponentType, 3>> maxima(number_of_chunks);
+  threader->ParallelizeArray(
+      0,
+      number_of_chunks,
+      [&](itk::SizeValueType chunk) {
+        std::array<ComponentType, 3> lo;
+        std::array<ComponentType, 3> hi;
+        lo.fill(itk::NumericTraits<ComponentType>::max());
+        hi.fill(itk::NumericTraits<ComponentType>::NonpositiveMin());
+        const itk::SizeValueType end = chunk_pixels(chunk + 1);
+        for (itk::SizeValueType p = chunk_pixels(chunk); p < end; ++p) {
+          for (unsigned int c = 0; c < 3; ++c) {
+            lo[c] = std::min(lo[c], pixels[3 * p + c]);
+            hi[c] = std::max(hi[c], pixels[3 * p + c]);
+          }
+        }
+        minima[chunk] = lo;
+        maxima[chunk] = hi;
+      },
+      nullptr
+      );
+
+  // The linear map of itk::RescaleIntensityImageFilter onto the full range
+  // of the channel type
+  const auto output_minimum
+    = static_cast<RealType>(std::numeric_limits<ComponentType>::min());
+  const auto output_maximum
+    = static_cast<RealType>(std::numeric_limits<ComponentType>::max());
+  std::array<RealType, 3> scale;
+  std::array<RealType, 3> shift;
+  for (unsigned int c = 0; c < 3; ++c) {
+    ComponentType input_minimum = minima[0][c];
+    ComponentType input_maximum = maxima[0][c];
+    for (itk::SizeValueType chunk = 1; chunk < number_of_chunks; ++chunk) {
+      input_minimum = std::min(input_minimum, minima[chunk][c]);
+      input_maximum = std::max(input_maximum, maxima[chunk][c]);
+    }
+
+    if (input_minimum != input_maximum) {
+      scale[c] = (output_maximum - output_minimum)
+        / (static_cast<RealType>(input_maximum)
+            - static_cast<RealType>(input_minimum));
+    } else if (
+        input_maximum != itk::NumericTraits<ComponentType>::ZeroValue()
+        ) {
+      scale[c] = (output_maximum - output_minimum)
+        / static_cast<RealType>(input_maximum);
+    } else {
+      scale[c] = 0.0;
+    }
+    shift[c] = output_minimum
+      - static_cast<RealType>(input_minimum) * scale[c];
+  }
+
+  // Pass 2: de-interleave and rescale the selected channels
+  threader->ParallelizeArray(
+      0,
+      number_of_chunks,
+      [&](itk::SizeValueType chunk) {
+        const itk::SizeValueType end = chunk_pixels(chunk + 1);
+        for (
+            itk::SizeValueType first = chunk_pixels(chunk);
+            first < end;
+            first += kBlockSize
+            ) {
+          const itk::SizeValueType last = std::min(end, first + kBlockSize);
+          for (unsigned int c = 0; c < 3; ++c) {
+            ComponentType *output = outputs[c];
+            if (nullptr == output) {
+              continue;
+            }
+            const RealType channel_scale = scale[c];
+            const RealType channel_shift = shift[c];
+            // The mapped values stay within the range of the channel type,
+            // so the clamping after the truncating cast of the filter is not
+            // needed
+            for (itk::SizeValueType p = first; p < last; ++p) {
+              const RealType value = static_cast<RealType>(pixels[3 * p + c])
+                * channel_scale + channel_shift;
+              output[p] = static_cast<ComponentType>(value);
+            }
+          }
+        }
+      },
+      nullptr
+      );
+
+  return channels;
+}
+
+
+// ----------------------------------------------------------------------------
+// 'writeRawChannels' template function
+// ----------------------------------------------------------------------------
+//
+// Description:
+// This function writes the selected channels of an interleaved RGB file
+// with their values as they are stored, without rescaling them. The pixels
+// are de-interleaved band of rows by band of rows, and every band is handed
+// to the TIFF image IO objects of the channels as a streamed region, so
+// neither the input nor the channels are held in memory whole. Files whose
+// pixel data can be mapped are not decoded at all.
+//
+// Template parameters:
+//   ComponentType: The type of the channel values.
+//
+// Parameters:
+//   tiff_io: TIFF image IO object with the image information already read.
+//   outputs: TIFF image IO objects writing the red, green and blue channels,
+//            with their file names set, null for the channels not selected.
+//
+// ----------------------------------------------------------------------------
+template <typename ComponentType>
+void writeRawChannels(
+    itk::TIFFImageIO *tiff_io,
+    const std::array<itk::TIFFImageIO::Pointer, 3> &outputs
+    ) {
+  // Number of bytes of the input de-interleaved at a time
+  constexpr itk::SizeValueType kBandSize = itk::SizeValueType{4} << 20;
+
+  const itk::SizeValueType width = tiff_io->GetDimensions(0);
+  const itk::SizeValueType height = tiff_io->GetDimensions(1);
+  const itk::SizeValueType band_rows = std::max<itk::SizeValueType>(
+      1,
+      kBandSize / (3 * sizeof(ComponentType) * width)
+      );
+
+  std::array<std::vector<ComponentType>, 3> channel_bands;
+  for (unsigned int c = 0; c < 3; ++c) {
+    if (!outputs[c]) {
+      continue;
+    }
+    outputs[c]->SetNumberOfDimensions(2);
+    for (unsigned int i = 0; i < 2; ++i) {
+      outputs[c]->SetDimensions(i, tiff_io->GetDimensions(i));
+      outputs[c]->SetSpacing(i, tiff_io->GetSpacing(i));
+      outputs[c]->SetOrigin(i, tiff_io->GetOrigin(i));
+    }
+    outputs[c]->SetPixelTypeInfo(static_cast<const ComponentType *>(nullptr));
+    outputs[c]->SetUseStreamedWriting(true);
+    channel_bands[c].resize(band_rows * width);
+  }
+
+  // Pixels that can not be mapped are decoded a band at a time
+  const auto *mapped_pixels
+    = static_cast<const ComponentType *>(tiff_io->MapPixelData());
+  std::vector<ComponentType> band;
+  if (nullptr == mapped_pixels) {
+    band.resize(3 * band_rows * width);
+  }
+
+  for (
+      itk::SizeValueType first_row = 0;
+      first_row < height;
+      first_row += band_rows
+      ) {
+    const itk::SizeValueType rows = std::min(band_rows, height - first_row);
+    itk::ImageIORegion io_region(2);
+    io_region.SetIndex(0, 0);
+    io_region.SetIndex(1, first_row);
+    io_region.SetSize(0, width);
+    io_region.SetSize(1, rows);
+
+    const ComponentType *pixels = band.data();
+    if (nullptr != mapped_pixels) {
+      pixels = mapped_pixels + 3 * first_row * width;
+    } else {
+      tiff_io->SetIORegion(io_region);
+      tiff_io->Read(band.data());
+    }
+
+    const itk::SizeValueType count = rows * width;
+    for (unsigned int c = 0; c < 3; ++c) {
+      if (!outputs[c]) {
+        continue;
+      }
+      ComponentType *channel = channel_bands[c].data();
+      for (itk::SizeValueType p = 0; p < count; ++p) {
+        channel[p] = pixels[3 * p + c];
+      }
+      outputs[c]->SetIORegion(io_region);
+      outputs[c]->Write(channel);
+    }
+  }
+}
 
 
 // ============================================================================
@@ -156,6 +521,8 @@ int main(int argc, char *argv[]) {
     std::string input_file;
     std::string channel;
     bool overwrite;
+    bool raw;
+    unsigned int tile_size;
     std::vector<std::string> unsupported;
   };
 
@@ -167,12 +534,17 @@ int main(int argc, char *argv[]) {
       "",           // input_file
       "all",        // channel
       false,        // overwrite
+      false,        // raw
+      0,            // tile_size
       {}            // unsupported options aggregator
   };
 
   // Option filters definitions
-  auto istarget = clipp::match::prefix_not("-"); // Filter out strings that
-                                                 // start with '-' (options)
+  // Filter out strings that start with '-' (options), except for the lone
+  // '-' standing for the standard input
+  auto istarget = [](const std::string &arg) {
+    return "-" == arg || clipp::match::prefix_not("-")(arg);
+  };
 
   // Set command line options
   auto parser_config = (
@@ -194,6 +566,14 @@ int main(int argc, char *argv[]) {
         clipp::option("-o", "--overwrite")
           .set(user_options.overwrite)
           .doc("overwrite existing files"),
+        clipp::option("-r", "--raw")
+          .set(user_options.raw)
+          .doc("write the channel values as they are stored, without "
+               "stretching them to the full range"),
+        clipp::option("-t", "--tile-size")
+          .doc("write tiled TIFF files of SIZE x SIZE pixels tiles, SIZE "
+               "being a multiple of 16 [default: strips]")
+        & clipp::value("SIZE", user_options.tile_size),
         clipp::option("-h", "--help")
            .set(user_options.show_help)
            .doc("show this help message and exit"),
@@ -276,6 +656,19 @@ int main(int argc, char *argv[]) {
 
     user_options.channel = ch;
 
+    // Check if the tile size is one TIFF allows
+    if (0 != user_options.tile_size % 16) {
+      std::cerr << kAppName
+        << ": Tile size is not a multiple of 16: "
+        << user_options.tile_size
+        << "\n";
+
+      // Print short help message
+      printShortHelp(exec_name);
+
+      throw EXIT_FAILURE;
+    }
+
     // No high priority switch was triggered. Now we check if the input
     // file was passed. If not we print the usage message and exit.
     if (user_options.input_file.empty()) {
@@ -294,10 +687,26 @@ int main(int argc, char *argv[]) {
       throw EXIT_FAILURE;
     }
 
-    // Input file was passed. Now we check if the file exists, is
-    // readable and is a regular file and not an empty file.
+    // Input file was passed. With '-' the image is piped through the
+    // standard input and output, so there are no files to check. As the
+    // standard output takes a single image, a single channel must be
+    // selected.
+    const bool use_std_streams = "-" == user_options.input_file;
+    if (use_std_streams && "all" == user_options.channel) {
+      std::cerr << kAppName
+        << ": Select a single color channel to read from the standard input"
+        << "\n";
+
+      // Print short help message
+      printShortHelp(exec_name);
+
+      throw EXIT_FAILURE;
+    }
+
+    // Now we check if the file exists, is readable and is a regular file
+    // and not an empty file.
     // Check if the file exists
-    if (!fs::exists (user_options.input_file)) {
+    if (!use_std_streams && !fs::exists (user_options.input_file)) {
       std::cerr << kAppName
         << ": File does not exist: "
         << user_options.input_file
@@ -306,7 +715,7 @@ int main(int argc, char *argv[]) {
     }
 
     // Check if the file is a regular file
-    if (!fs::is_regular_file (user_options.input_file)) {
+    if (!use_std_streams && !fs::is_regular_file (user_options.input_file)) {
       std::cerr << kAppName
         << ": Not a regular file: "
         << user_options.input_file
@@ -315,7 +724,7 @@ int main(int argc, char *argv[]) {
     }
 
     // Check if the file is empty
-    if (fs::file_size (user_options.input_file) == 0) {
+    if (!use_std_streams && fs::file_size (user_options.input_file) == 0) {
       std::cerr << kAppName
         << ": Empty file: "
         << user_options.input_file
@@ -323,40 +732,53 @@ int main(int argc, char *argv[]) {
       throw EXIT_FAILURE;
     }
 
-    // Open the file in binary mode for wider compatibility
-    std::ifstream file (
-      user_options.input_file,
-      std::ios::binary
-      );
-
-    // Check if the file was opened successfully
-    // (if we can read it)
-    if (!file.is_open()) {
-      std::cerr << kAppName
-        << ": Error opening file: "
-        << user_options.input_file
-        << "\n";
-      throw EXIT_FAILURE;
-    }
-
     // Decompose the input file name into the base name and the extension
     std::string out_base_name
       = fs::path(user_options.input_file).stem().string();
     std::string out_extension
       = fs::path(user_options.input_file).extension().string();
 
+    // Output files written to the standard output, for which no image IO is
+    // registered, tiled or raw are written with a TIFF image IO set explicitly
+    const bool use_output_io = use_std_streams || 0 < user_options.tile_size;
+
+    // Files written with the TIFF image IO get a TIFF extension, whatever
+    // the format of the input file is
+    const std::string in_extension = str_tolower(out_extension);
+    if (
+        (use_output_io || user_options.raw)
+        && ".tif" != in_extension
+        && ".tiff" != in_extension
+        ) {
+      out_extension = ".tif";
+    }
+
+    // Name of the output file of the channel with the given suffix
+    const auto out_file_name = [&](const std::string &suffix) {
+      return use_std_streams
+        ? std::string("-")
+        : out_base_name + suffix + out_extension;
+    };
+
+    const auto make_output_io = [&]() {
+      auto output_io = itk::TIFFImageIO::New();
+      output_io->SetTileSize(user_options.tile_size, user_options.tile_size);
+      return output_io;
+    };
+
     // Check if the output file(s) already exists
     if (
         ("r" == user_options.channel
           || "red" == user_options.channel
           || "all" == user_options.channel
           )
+        && !use_std_streams
         && !user_options.overwrite
-        && fs::exists (out_base_name + "_R" + out_extension)
+        && fs::exists (out_file_name("_R"))
         ) {
       std::cerr << kAppName
         << ": Output file already exists: "
-        << out_base_name << "_R" << out_extension
+        << out_file_name("_R")
         << "\n";
       throw EXIT_FAILURE;
     }
@@ -365,12 +787,13 @@ int main(int argc, char *argv[]) {
           || "green" == user_options.channel
           || "all" == user_options.channel
           )
+        && !use_std_streams
         && !user_options.overwrite
-        && fs::exists (out_base_name + "_G" + out_extension)
+        && fs::exists (out_file_name("_G"))
         ) {
       std::cerr << kAppName
         << ": Output file already exists: "
-        << out_base_name << "_G" << out_extension
+        << out_file_name("_G")
         << "\n";
       throw EXIT_FAILURE;
     }
@@ -379,12 +802,13 @@ int main(int argc, char *argv[]) {
           || "blue" == user_options.channel
           || "all" == user_options.channel
           )
+        && !use_std_streams
         && !user_options.overwrite
-        && fs::exists (out_base_name + "_B" + out_extension)
+        && fs::exists (out_file_name("_B"))
         ) {
       std::cerr << kAppName
         << ": Output file already exists: "
-        << out_base_name << "_B" << out_extension
+        << out_file_name("_B")
         << "\n";
       throw EXIT_FAILURE;
     }
@@ -402,21 +826,12 @@ int main(int argc, char *argv[]) {
       throw EXIT_FAILURE;
     }
 
-    // Set the file name and read the image information
+    // Set the file name and read the baseline tags of the first directory
     tiffImageIO->SetFileName(user_options.input_file);
-    tiffImageIO->ReadImageInformation();
-
-    // Check if we are dealing with an compressed image
-    if (tiffImageIO->ReadCompressionFromImage() != 1) {  // 1 = no compression
-      std::cerr << kAppName
-        << ": File is compressed: "
-        << user_options.input_file
-        << "\n";
-      throw EXIT_FAILURE;
-    }
+    const auto tags = tiffImageIO->ReadTagSnapshot();
 
     // Check if we are dealing with the RGB image
-    if (tiffImageIO->ReadSamplesPerPixelFromImage() != 3) {
+    if (tags.SamplesPerPixel != 3) {
       std::cerr << kAppName
         << ": File is not an RGB image: "
         << user_options.input_file
@@ -425,7 +840,7 @@ int main(int argc, char *argv[]) {
     }
 
     // Check if we are dealing with 16-bit image
-    if (tiffImageIO->ReadBitsPerSampleFromImage() != 16) {
+    if (tags.BitsPerSample != 16) {
       std::cerr << kAppName
         << ": File is not a 16-bit image: "
         << user_options.input_file
@@ -433,107 +848,153 @@ int main(int argc, char *argv[]) {
       throw EXIT_FAILURE;
     }
 
-    // Define accessor and utility classes for accessing the color channels
+    // Read the image information only once the header checks out
+    tiffImageIO->ReadImageInformation();
+
     // Define image types for the input and output images
     using RGB16Image = itk::Image<RGB16Pixel, 2>;
     using Mono16Image = itk::Image<uint16_t, 2>;
 
     // Define the image reader and writer types
     using RGB16Reader = itk::ImageFileReader<RGB16Image>;
+    using RGB16Importer = itk::ImportImageFilter<RGB16Pixel, 2>;
     using Mono16Writer = itk::ImageFileWriter<Mono16Image>;
 
-    // Define the adaptors for the color channels
-    using RedChannelAdaptor = itk::ImageAdaptor<RGB16Image,
-        RGB16ColorChannelAccessor<ColorChannel::R>>;
-    using GreenChannelAdaptor = itk::ImageAdaptor<RGB16Image,
-        RGB16ColorChannelAccessor<ColorChannel::G>>;
-    using BlueChannelAdaptor = itk::ImageAdaptor<RGB16Image,
-        RGB16ColorChannelAccessor<ColorChannel::B>>;
-    using RedChannelRescalerType
-      = itk::RescaleIntensityImageFilter<RedChannelAdaptor, Mono16Image>;
-    using GreenChannelRescalerType
-      = itk::RescaleIntensityImageFilter<GreenChannelAdaptor, Mono16Image>;
-    using BlueChannelRescalerType
-      = itk::RescaleIntensityImageFilter<BlueChannelAdaptor, Mono16Image>;
-    
-    // Instantiate objects and connect them
-    auto reader = RGB16Reader::New();
-    reader->SetFileName(user_options.input_file);
-    auto red_channel = RedChannelAdaptor::New();
-    red_channel->SetImage(reader->GetOutput());
-    auto green_channel = GreenChannelAdaptor::New();
-    green_channel->SetImage(reader->GetOutput());
-    auto blue_channel = BlueChannelAdaptor::New();
-    blue_channel->SetImage(reader->GetOutput());
-    auto red_rescaler = RedChannelRescalerType::New();
-    red_rescaler->SetOutputMinimum(std::numeric_limits<uint16_t>::min());
-    red_rescaler->SetOutputMaximum(std::numeric_limits<uint16_t>::max());
-    red_rescaler->SetInput(red_channel);
-    auto green_rescaler = GreenChannelRescalerType::New();
-    green_rescaler->SetOutputMinimum(std::numeric_limits<uint16_t>::min());
-    green_rescaler->SetOutputMaximum(std::numeric_limits<uint16_t>::max());
-    green_rescaler->SetInput(green_channel);
-    auto blue_rescaler = BlueChannelRescalerType::New();
-    blue_rescaler->SetOutputMinimum(std::numeric_limits<uint16_t>::min());
-    blue_rescaler->SetOutputMaximum(std::numeric_limits<uint16_t>::max());
-    blue_rescaler->SetInput(blue_channel);
-    auto red_writer = Mono16Writer::New();
-    red_writer->SetFileName((out_base_name + "_R" + out_extension).c_str());
-    red_writer->SetInput(red_rescaler->GetOutput());
-    auto green_writer = Mono16Writer::New();
-    green_writer->SetFileName((out_base_name + "_G" + out_extension).c_str());
-    green_writer->SetInput(green_rescaler->GetOutput());
-    auto blue_writer = Mono16Writer::New();
-    blue_writer->SetFileName((out_base_name + "_B" + out_extension).c_str());
-    blue_writer->SetInput(blue_rescaler->GetOutput());
+    // Define the color channels and the samples holding them
+    struct ChannelPlane {
+      std::string short_name;
+      std::string long_name;
+      std::string suffix;
+      unsigned int sample;
+    };
+    const std::vector<ChannelPlane> channel_planes = {
+      {"r", "red", "_R", 0},
+      {"g", "green", "_G", 1},
+      {"b", "blue", "_B", 2}
+    };
+    const auto is_selected = [&](const ChannelPlane &plane) {
+      return plane.short_name == user_options.channel
+        || plane.long_name == user_options.channel
+        || "all" == user_options.channel;
+    };
+
+    // Planar files store every channel in a separate plane (planar
+    // configuration 2), so each requested channel is read with a single
+    // sequential pass and without de-interleaving the pixels
+    if (2 == tags.PlanarConfig) {
+      using PlaneRescalerType
+        = itk::RescaleIntensityImageFilter<Mono16Image, Mono16Image>;
+
+      for (const auto &plane : channel_planes) {
+        if (!is_selected(plane)) {
+          continue;
+        }
+
+        auto plane_rescaler = PlaneRescalerType::New();
+        plane_rescaler->SetOutputMinimum(std::numeric_limits<uint16_t>::min());
+        plane_rescaler->SetOutputMaximum(std::numeric_limits<uint16_t>::max());
+        auto plane_writer = Mono16Writer::New();
+        plane_writer->SetFileName(out_file_name(plane.suffix).c_str());
+        if (use_output_io) {
+          plane_writer->SetImageIO(make_output_io());
+        }
+        try {
+          auto plane_image
+            = readChannelPlane<Mono16Image>(tiffImageIO, plane.sample);
+          if (user_options.raw) {
+            plane_writer->SetInput(plane_image);
+          } else {
+            plane_rescaler->SetInput(plane_image);
+            plane_writer->SetInput(plane_rescaler->GetOutput());
+          }
+          plane_writer->Update();
+        } catch (const itk::ExceptionObject & error) {
+          std::cerr << kAppName
+            << ": Error writing file: '"
+            << out_file_name(plane.suffix)
+            << "'. "
+            << error
+            << "\n";
+          throw EXIT_FAILURE;
+        }
+      }
 
+      // Return success
+      throw EXIT_SUCCESS;
+    }
 
-    // Write channels to files
-    if (
-        "r" == user_options.channel
-        || "red" == user_options.channel
-        || "all" == user_options.channel
-        ) {
-      try {
-        red_writer->Update();
-      } catch (const itk::ExceptionObject & error) {
-        std::cerr << kAppName
-          << ": Error writing file: '"
-          << out_base_name << "_R" << out_extension
-          << "'. "
-          << error
-          << "\n";
-        throw EXIT_FAILURE;
+    // In raw mode interleaved files are only de-interleaved, band by band,
+    // straight into the output files
+    if (user_options.raw) {
+      std::array<itk::TIFFImageIO::Pointer, 3> outputs;
+      for (const auto &plane : channel_planes) {
+        if (is_selected(plane)) {
+          outputs[plane.sample] = make_output_io();
+          outputs[plane.sample]->SetFileName(out_file_name(plane.suffix));
+        }
       }
-    }
-    if (
-        "g" == user_options.channel
-        || "green" == user_options.channel
-        || "all" == user_options.channel
-        ) {
       try {
-        green_writer->Update();
+        writeRawChannels<uint16_t>(tiffImageIO, outputs);
       } catch (const itk::ExceptionObject & error) {
         std::cerr << kAppName
-          << ": Error writing file: '"
-          << out_base_name << "_G" << out_extension
+          << ": Error splitting file: '"
+          << user_options.input_file
           << "'. "
           << error
           << "\n";
         throw EXIT_FAILURE;
       }
+
+      // Return success
+      throw EXIT_SUCCESS;
     }
-    if (
-        "b" == user_options.channel
-        || "blue" == user_options.channel
-        || "all" == user_options.channel
-        ) {
+
+    // Interleaved files are split by a single fused kernel, which reads the
+    // pixels twice for all of the selected channels
+    auto reader = RGB16Reader::New();
+    auto importer = RGB16Importer::New();
+    RGB16Image * input_image = getInputImage(
+        tiffImageIO,
+        user_options.input_file,
+        reader,
+        importer
+        );
+    std::array<bool, 3> selected{false, false, false};
+    for (const auto &plane : channel_planes) {
+      selected[plane.sample] = is_selected(plane);
+    }
+    std::array<Mono16Image::Pointer, 3> channels;
+    try {
+      input_image->Update();
+      channels = splitChannels<RGB16Image, Mono16Image>(input_image, selected);
+    } catch (const itk::ExceptionObject & error) {
+      std::cerr << kAppName
+        << ": Error reading file: '"
+        << user_options.input_file
+        << "'. "
+        << error
+        << "\n";
+      throw EXIT_FAILURE;
+    }
+
+    // Write channels to files
+    for (const auto &plane : channel_planes) {
+      if (!selected[plane.sample]) {
+        continue;
+      }
+
+      auto writer = Mono16Writer::New();
+      writer->SetFileName(out_file_name(plane.suffix).c_str());
+      writer->SetInput(channels[plane.sample]);
+      if (use_output_io) {
+        writer->SetImageIO(make_output_io());
+      }
       try {
-        blue_writer->Update();
+        writer->Update();
       } catch (const itk::ExceptionObject & error) {
         std::cerr << kAppName
           << ": Error writing file: '"
-          << out_base_name << "_B" << out_extension
+          << out_file_name(plane.suffix)
           << "'. "
           << error
           << "\n";